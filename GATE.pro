@@ -52,12 +52,14 @@ INCLUDEPATH += ../VOIP_DISPATCHER/opus-1.3/win32/
 
 
 SOURCES += \
-    audiotree.cpp \
+    alarmtracker.cpp \
+    archivemodel.cpp \
+    archivereader.cpp \
     coloredsqlquerymodel.cpp \
     dialogdate.cpp \
     dialoginputsconfig.cpp \
     dialogvolumeconfig.cpp \
-    group.cpp \
+    flightrecorder.cpp \
     groupdata.cpp \
         main.cpp \
         mainwindow.cpp \
@@ -97,12 +99,23 @@ SOURCES += \
     audioinputdevice.cpp \
     checksum.cpp \
     mp3recorder.cpp \
-    point.cpp \
     pointdata.cpp \
     projectconfig.cpp \
+    recorddiff.cpp \
+    recordmanager.cpp \
+    recordwriter.cpp \
+    reportfilter.cpp \
+    rollup.cpp \
+    scopebuffer.cpp \
+    statemodel.cpp \
     sqldriver.cpp \
     sqlmanager.cpp \
+    sqlschema.cpp \
+    sqlspool.cpp \
+    transcodepool.cpp \
     udpworker.cpp \
+    waveformpyramid.cpp \
+    waveformview.cpp \
     udpcontroller.cpp \
     qcustomplot.cpp \
     audiooutputdevice.cpp \
@@ -286,24 +299,37 @@ SOURCES += \
     opus-1.3/src/repacketizer.c
 
 HEADERS += \
-    audiotree.h \
+    alarmtracker.h \
+    archivemodel.h \
+    archivereader.h \
     coloredsqlquerymodel.h \
     dialogdate.h \
     dialoginputsconfig.h \
     dialogvolumeconfig.h \
+    flightrecorder.h \
     enums.h \
-    group.h \
     groupdata.h \
         mainwindow.h \
     audioinputdevice.h \
     checksum.h \
     mp3recorder.h \
-    point.h \
     pointdata.h \
     projectconfig.h \
+    recorddiff.h \
+    recordmanager.h \
+    recordwriter.h \
+    reportfilter.h \
+    rollup.h \
+    scopebuffer.h \
+    statemodel.h \
     sqldriver.h \
     sqlmanager.h \
+    sqlschema.h \
+    sqlspool.h \
+    transcodepool.h \
     udpworker.h \
+    waveformpyramid.h \
+    waveformview.h \
     udpcontroller.h \
     qcustomplot.h \
     audiooutputdevice.h \
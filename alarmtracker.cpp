@@ -0,0 +1,41 @@
+#include "alarmtracker.h"
+
+AlarmTracker::Transition AlarmTracker::update(const AlarmKey &key, bool active, const QString &message, const QString &type, qint64 time)
+{
+    checks++;
+    auto it = alarms.find(key);
+    if(!active) {
+        // условие в норме и до этого: писать нечего
+        if(it==alarms.end()) return Transition::NONE;
+        alarms.erase(it);
+        transitions++;
+        return Transition::CLEAR;
+    }
+    if(it!=alarms.end() && it->second.message==message && it->second.type==type) return Transition::NONE;
+    // новая тревога или активная сменила текст (обрыв -> замыкание) - квитирование сбрасывается
+    AlarmState &s = alarms[key];
+    s.message = message;
+    s.type = type;
+    s.since = time;
+    s.acked = false;
+    transitions++;
+    return Transition::RAISE;
+}
+
+void AlarmTracker::restore(const AlarmKey &key, const AlarmState &state)
+{
+    // уже известное состояние условия новее среза
+    alarms.emplace(key,state);
+}
+
+std::vector<std::pair<AlarmKey,AlarmState>> AlarmTracker::acknowledge()
+{
+    std::vector<std::pair<AlarmKey,AlarmState>> acked;
+    for(auto &a:alarms) {
+        if(a.second.acked) continue;
+        a.second.acked = true;
+        acked.push_back(a);
+        transitions++;
+    }
+    return acked;
+}
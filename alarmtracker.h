@@ -0,0 +1,52 @@
+#ifndef ALARMTRACKER_H
+#define ALARMTRACKER_H
+
+#include <QString>
+#include <map>
+#include <vector>
+#include <tuple>
+
+enum class AlarmCondition {NO_DATA,DI1,DI2,SPEAKER,POINTS};
+
+// ключ условия: шлюз, группа, точка (0 - условие группы), условие
+struct AlarmKey {
+    QString ip;
+    quint8 gate = 0;
+    quint8 point = 0;
+    AlarmCondition condition = AlarmCondition::NO_DATA;
+    bool operator<(const AlarmKey &other) const {
+        return std::tie(ip,gate,point,condition) < std::tie(other.ip,other.gate,other.point,other.condition);
+    }
+};
+
+struct AlarmState {
+    QString message;
+    QString type;
+    qint64 since = 0;       // мс с начала эпохи
+    bool acked = false;
+};
+
+// состояние тревог в памяти: в журнал тревог пишутся только переходы
+// появление (или смена текста активной тревоги), снятие и квитирование
+class AlarmTracker
+{
+public:
+    enum class Transition {NONE,RAISE,CLEAR};
+
+    // active==false - условие в норме, message и type - текст записи о снятии
+    Transition update(const AlarmKey &key, bool active, const QString &message, const QString &type, qint64 time);
+    // активная тревога из среза базы после перезапуска, без записи перехода
+    void restore(const AlarmKey &key, const AlarmState &state);
+    // квитирование всех активных тревог, возвращает ещё не квитированные
+    std::vector<std::pair<AlarmKey,AlarmState>> acknowledge();
+    const std::map<AlarmKey,AlarmState> &active() const {return alarms;}
+    quint64 getChecks() const {return checks;}
+    quint64 getTransitions() const {return transitions;}
+
+private:
+    std::map<AlarmKey,AlarmState> alarms;
+    quint64 checks = 0;         // проверок условий - столько строк писалось до отбора переходов
+    quint64 transitions = 0;
+};
+
+#endif // ALARMTRACKER_H
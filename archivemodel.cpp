@@ -0,0 +1,109 @@
+#include "archivemodel.h"
+#include "coloredsqlquerymodel.h"
+
+ArchiveModel::ArchiveModel(int id, QObject *parent) : QAbstractTableModel(parent), id(id)
+{
+
+}
+
+void ArchiveModel::setQuery(const QString &columns, const QString &source, const QStringList &headers)
+{
+    beginResetModel();
+    // за видимыми столбцами читатель добавляет id и tmr ключа страницы
+    this->columns = columns;
+    this->source = source;
+    this->headers = headers;
+    rows.clear();
+    buffer.clear();
+    lastTmr = QVariant();
+    lastId = QVariant();
+    generation++;
+    loading = false;
+    finished = false;
+    fetchWanted = true;
+    endResetModel();
+    requestNext();
+}
+
+void ArchiveModel::requestNext()
+{
+    if(loading || finished) return;
+    loading = true;
+    ArchiveRequest r;
+    r.model = id;
+    r.generation = generation;
+    r.columns = columns;
+    r.source = source;
+    r.lastTmr = lastTmr;
+    r.lastId = lastId;
+    r.limit = pageSize;
+    emit pageRequested(r);
+}
+
+void ArchiveModel::appendBuffer()
+{
+    if(buffer.isEmpty()) return;
+    beginInsertRows(QModelIndex(),rows.size(),rows.size()+buffer.size()-1);
+    rows += buffer;
+    buffer.clear();
+    endInsertRows();
+}
+
+void ArchiveModel::pageLoaded(const ArchivePage &page)
+{
+    // ответ на запрос до смены интервала
+    if(page.generation!=generation) return;
+    buffer += page.rows;
+    if(!page.rows.isEmpty()) {
+        const QVector<QVariant> &last = page.rows.last();
+        lastId = last.value(headers.size());
+        lastTmr = last.value(headers.size()+1);
+    }
+    // строки, которых ждёт таблица, показываются по мере прихода
+    if(fetchWanted) appendBuffer();
+    if(!page.done) return;
+    loading = false;
+    finished = page.last;
+    fetchWanted = false;
+    // следующая страница загружается заранее, пока оператор смотрит текущую
+    if(buffer.isEmpty()) requestNext();
+}
+
+int ArchiveModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : rows.size();
+}
+
+int ArchiveModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : headers.size();
+}
+
+QVariant ArchiveModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid() || index.row()>=rows.size() || index.column()>=headers.size()) return QVariant();
+    const QVariant &value = rows.at(index.row()).value(index.column());
+    if(role==Qt::DisplayRole || role==Qt::EditRole) return value;
+    if(role==Qt::BackgroundRole) return ColoredSqlQueryModel::background(value.toString());
+    return QVariant();
+}
+
+QVariant ArchiveModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if(orientation==Qt::Horizontal && role==Qt::DisplayRole && section<headers.size()) return headers.at(section);
+    return QAbstractTableModel::headerData(section,orientation,role);
+}
+
+bool ArchiveModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && (!buffer.isEmpty() || !finished);
+}
+
+void ArchiveModel::fetchMore(const QModelIndex &parent)
+{
+    if(parent.isValid()) return;
+    // страница ещё не пришла - добавим её строки по приходу
+    if(buffer.isEmpty()) fetchWanted = true;
+    appendBuffer();
+    requestNext();
+}
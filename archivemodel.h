@@ -0,0 +1,70 @@
+#ifndef ARCHIVEMODEL_H
+#define ARCHIVEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+// запрос очередной страницы архива: строки старше ключа последней полученной строки
+struct ArchiveRequest {
+    int model = 0;
+    quint64 generation = 0;
+    QString columns;        // видимые столбцы, ключ страницы добавляет читатель
+    QString source;         // FROM ... WHERE ... без сортировки и ограничения
+    QVariant lastTmr;       // ключ (tmr,id) последней строки в виде столбца ключа читателя, пустой для первой страницы
+    QVariant lastId;
+    int limit = 0;
+};
+
+struct ArchivePage {
+    int model = 0;
+    quint64 generation = 0;
+    QVector<QVector<QVariant>> rows;
+    bool done = false;      // страница получена полностью, до этого строки приходят пачками
+    bool last = false;      // строк старше этой страницы нет
+};
+
+Q_DECLARE_METATYPE(ArchivePage)
+
+// архивная таблица с постраничной загрузкой по ключу (tmr,id) от новых записей к старым
+// первая страница показывается сразу, следующая запрашивается заранее и добавляется при прокрутке
+class ArchiveModel : public QAbstractTableModel
+{
+    Q_OBJECT
+    int id;
+    quint64 generation = 0;
+    QString columns;
+    QString source;
+    QStringList headers;
+    QVector<QVector<QVariant>> rows;
+    QVector<QVector<QVariant>> buffer;
+    QVariant lastTmr;
+    QVariant lastId;
+    bool loading = false;
+    bool finished = true;
+    bool fetchWanted = false;
+
+    void requestNext();
+    void appendBuffer();
+
+public:
+    static const int pageSize = 200;
+
+    explicit ArchiveModel(int id, QObject *parent = nullptr);
+    // columns - видимые столбцы, первый из них tmr; source - FROM ... WHERE ...
+    void setQuery(const QString &columns, const QString &source, const QStringList &headers);
+    void pageLoaded(const ArchivePage &page);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+signals:
+    void pageRequested(const ArchiveRequest &request);
+};
+
+#endif // ARCHIVEMODEL_H
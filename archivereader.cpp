@@ -0,0 +1,189 @@
+#include "archivereader.h"
+#include "sqldriver.h"
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QDateTime>
+#include <algorithm>
+
+ArchiveReader::ArchiveReader(const QString &connectionName, QObject *parent) : QObject(parent), connectionName(connectionName)
+{
+
+}
+
+void ArchiveReader::finish()
+{
+    QMutexLocker locker(&mutex);
+    finishFlag = true;
+    wake.wakeOne();
+}
+
+void ArchiveReader::initDB()
+{
+    QMutexLocker locker(&mutex);
+    initFlag = true;
+    wake.wakeOne();
+}
+
+void ArchiveReader::request(const ArchiveRequest &request)
+{
+    QMutexLocker locker(&mutex);
+    generations[request.model] = request.generation;
+    // более ранний запрос той же таблицы уже не нужен
+    requests.erase(std::remove_if(requests.begin(),requests.end(),[&](const ArchiveRequest &r){
+        return r.model==request.model;
+    }),requests.end());
+    requests.push_back(request);
+    wake.wakeOne();
+}
+
+int ArchiveReader::supersede(int model, quint64 generation)
+{
+    QMutexLocker locker(&mutex);
+    generations[model] = generation;
+    requests.erase(std::remove_if(requests.begin(),requests.end(),[&](const ArchiveRequest &r){
+        return r.model==model;
+    }),requests.end());
+    return static_cast<int>(requests.size())+(busy ? 1 : 0);
+}
+
+bool ArchiveReader::cancelled(const ArchiveRequest &request)
+{
+    QMutexLocker locker(&mutex);
+    return finishFlag || generations[request.model]!=request.generation;
+}
+
+bool ArchiveReader::openConnection()
+{
+    if(db.isOpen()) return true;
+    // попытки не чаще периода: при недоступной базе запросы завершаются сразу, а не ждут таймаута подключения
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if(now-lastConnectAttempt<reconnectPeriodMs) return false;
+    lastConnectAttempt = now;
+    mutex.lock();
+    DBSettings current = settings;
+    mutex.unlock();
+    if(!SQLDriver::openDatabase(db,current,connectionName)) {
+        if(!connectionLost) emit error("ОШИБКА ПОДКЛЮЧЕНИЯ К АРХИВУ!");
+        connectionLost = true;
+        return false;
+    }
+    connectionLost = false;
+    if(!sqlite()) {
+        // соединение только читает и не держит блокировок, зависший запрос прерывается сервером
+        QSqlQuery query(db);
+        query.exec("SET SESSION CHARACTERISTICS AS TRANSACTION READ ONLY;");
+        query.exec("SET statement_timeout = " + QString::number(statementTimeoutMs) + ";");
+    }
+    return true;
+}
+
+void ArchiveReader::fail(const ArchiveRequest &request)
+{
+    // пустая завершённая страница снимает с таблицы состояние загрузки
+    ArchivePage page;
+    page.model = request.model;
+    page.generation = request.generation;
+    page.done = true;
+    page.last = true;
+    emit pageLoaded(page);
+}
+
+bool ArchiveReader::load(const ArchiveRequest &request)
+{
+    ArchivePage page;
+    page.model = request.model;
+    page.generation = request.generation;
+    // ключ страницы сравнивается с tmr в его собственном типе: текст времени зависит от DateStyle,
+    // а QDateTime теряет микросекунды и строки на границе страницы
+    // PostgreSQL - микросекунды от 1970 целым числом, SQLite хранит tmr текстом и отдаёт его без изменений
+    QString key = sqlite() ? "tmr" : "CAST(EXTRACT(EPOCH FROM tmr)*1000000 AS BIGINT)";
+    QString sql = "SELECT " + request.columns + ",id," + key + " " + request.source;
+    if(request.lastId.isValid()) {
+        if(sqlite()) sql += " and (tmr,id) < (?,?)";
+        else sql += " and (tmr,id) < (TIMESTAMP 'epoch' + CAST(? AS BIGINT) * INTERVAL '1 microsecond',?)";
+    }
+    // лишняя строка показывает, есть ли следующая страница
+    sql += " ORDER BY tmr DESC, id DESC LIMIT " + QString::number(request.limit+1) + ";";
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(sql);
+    if(request.lastId.isValid()) {
+        query.addBindValue(request.lastTmr);
+        query.addBindValue(request.lastId);
+    }
+    int count = 0;
+    page.last = true;
+    busy = true;
+    if(query.exec()) {
+        int columns = query.record().count();
+        while(query.next()) {
+            if(count==request.limit) {
+                page.last = false;
+                break;
+            }
+            QVector<QVariant> row(columns);
+            for(int i=0;i<columns;i++) row[i] = query.value(i);
+            page.rows.append(row);
+            count++;
+            if(page.rows.size()==batchRows) {
+                // оператор сменил интервал - остаток страницы не нужен
+                if(cancelled(request)) {busy = false;return true;}
+                emit pageLoaded(page);
+                page.rows.clear();
+            }
+        }
+    }else {
+        busy = false;
+        // обрыв соединения: запрос повторяется после переподключения
+        QSqlQuery check(db);
+        if(!check.exec("SELECT 1;")) return false;
+        emit error("ОШИБКА ЗАПРОСА АРХИВА!");
+    }
+    busy = false;
+    if(cancelled(request)) return true;
+    page.done = true;
+    emit pageLoaded(page);
+    return true;
+}
+
+void ArchiveReader::work()
+{
+    for(;;) {
+        bool dbOpenState = db.isOpen();
+        mutex.lock();
+        if(!finishFlag && !initFlag && (requests.empty() || !connectWanted)) {
+            // без соединения поток просыпается по периоду для повторного подключения
+            if(connectWanted && !dbOpenState) wake.wait(&mutex,reconnectPeriodMs);
+            else wake.wait(&mutex);
+        }
+        bool finishFlagState = finishFlag;
+        bool initFlagState = initFlag;
+        initFlag = false;
+        if(initFlagState) connectWanted = true;
+        std::deque<ArchiveRequest> pending;
+        if(connectWanted) pending.swap(requests);
+        mutex.unlock();
+
+        if(finishFlagState) break;
+        if(initFlagState) {
+            // новые настройки: соединение открывается заново
+            db.close();
+            lastConnectAttempt = 0;
+            connectionLost = false;
+        }
+        if(connectWanted) openConnection();
+        for(const ArchiveRequest &r:pending) {
+            if(cancelled(r)) continue;
+            if(db.isOpen() && load(r)) continue;
+            if(db.isOpen()) {
+                db.close();
+                lastConnectAttempt = 0;
+            }
+            if(openConnection() && load(r)) continue;
+            fail(r);
+        }
+    }
+    db.close();
+    db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(connectionName);
+}
@@ -0,0 +1,61 @@
+#ifndef ARCHIVEREADER_H
+#define ARCHIVEREADER_H
+
+#include <QObject>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QSqlDatabase>
+#include <deque>
+#include <map>
+#include <atomic>
+#include "archivemodel.h"
+#include "projectconfig.h"
+
+// чтение архива в отдельном потоке через собственное соединение
+// запись телеметрии в SQLDriver не ждёт запросов оператора, строки уходят в модели пачками
+class ArchiveReader : public QObject
+{
+    Q_OBJECT
+    QMutex mutex;
+    QWaitCondition wake;
+    bool finishFlag = false;
+    bool initFlag = false;
+    DBSettings settings;
+    std::deque<ArchiveRequest> requests;
+    std::map<int,quint64> generations;     // последний запрошенный интервал каждой таблицы
+    QSqlDatabase db;
+    QString connectionName;
+    std::atomic<bool> busy{false};
+    bool connectWanted = false;         // после initDB соединение держится открытым
+    bool connectionLost = false;
+    qint64 lastConnectAttempt = 0;
+
+    static const int batchRows = 50;
+    static const int statementTimeoutMs = 60000;
+    static const int reconnectPeriodMs = 5000;
+
+    bool sqlite() const {return db.driverName()=="QSQLITE";}
+    bool cancelled(const ArchiveRequest &request);
+    bool openConnection();
+    bool load(const ArchiveRequest &request);
+    void fail(const ArchiveRequest &request);
+
+public:
+    explicit ArchiveReader(const QString &connectionName, QObject *parent = nullptr);
+    void finish();
+    void initDB();
+    void setDBSettings(const DBSettings &value) {QMutexLocker locker(&mutex);settings=value;}
+    // новый интервал той же таблицы отменяет загрузку прежнего
+    void request(const ArchiveRequest &request);
+    // отмена прежних запросов таблицы, отданных этому читателю; возвращает занятость читателя
+    int supersede(int model, quint64 generation);
+    bool isBusy() const {return busy;}
+
+signals:
+    void pageLoaded(const ArchivePage &page);
+    void error(const QString &message);
+public slots:
+    void work();
+};
+
+#endif // ARCHIVEREADER_H
@@ -7,13 +7,20 @@ ColoredSqlQueryModel::ColoredSqlQueryModel(QObject *parent):QSqlQueryModel (pare
 
 }
 
+QVariant ColoredSqlQueryModel::background(const QString &text)
+{
+    QString txt = text.toLower();
+    if(txt.contains("авария")) return QBrush(QColor(255,0,0,150));
+    else if(txt.contains("предупреждение")) return QBrush(QColor(255,255,0,150));
+    else if(txt.contains("сообщение")) return QBrush(QColor(0,255,0,150));
+    return QVariant();
+}
+
 QVariant ColoredSqlQueryModel::data(const QModelIndex &index, int role) const
 {
     if (role == Qt::BackgroundRole) {
-       QString txt = data(index, Qt::DisplayRole).toString().toLower();
-       if(txt.contains("авария")) return QBrush(QColor(255,0,0,150));
-       else if(txt.contains("предупреждение")) return QBrush(QColor(255,255,0,150));
-       else if(txt.contains("сообщение")) return QBrush(QColor(0,255,0,150));
+       QVariant brush = background(data(index, Qt::DisplayRole).toString());
+       if(brush.isValid()) return brush;
     }
     return QSqlQueryModel::data(index, role);
 }
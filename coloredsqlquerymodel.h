@@ -8,6 +8,8 @@ class ColoredSqlQueryModel : public QSqlQueryModel
 {
 public:
     explicit ColoredSqlQueryModel(QObject *parent=nullptr);
+    // цвет строки по типу сообщения
+    static QVariant background(const QString &text);
 
     // QAbstractItemModel interface
 public:
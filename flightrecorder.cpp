@@ -0,0 +1,209 @@
+#include "flightrecorder.h"
+#include "checksum.h"
+#include "pointdata.h"
+#include "groupdata.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QHostAddress>
+#include <QTextStream>
+#include <QDataStream>
+#include <map>
+#include <tuple>
+#include <cstring>
+#include <algorithm>
+
+static_assert(std::atomic<quint64>::is_always_lock_free, "flight recorder needs lock-free 64-bit atomics");
+
+FlightRecorder::FlightRecorder(const QString &fileName, qint64 capacity) : file(fileName)
+{
+    capacity = static_cast<qint64>(align(static_cast<quint64>(capacity)));
+    if(!file.open(QIODevice::ReadWrite)) return;
+    // журнал прошлого запуска сохраняется, если совпадает формат
+    bool reuse = false;
+    if(file.size()==headerSize+capacity) {
+        FileHeader h;
+        if(file.read(reinterpret_cast<char*>(&h),sizeof(quint32)*2+sizeof(quint64))==sizeof(quint32)*2+sizeof(quint64)) {
+            reuse = h.magic==fileMagic && h.version==1 && h.capacity==static_cast<quint64>(capacity);
+        }
+    }
+    if(!reuse && !file.resize(headerSize+capacity)) {file.close();return;}
+    map = file.map(0,headerSize+capacity);
+    if(!map) {file.close();return;}
+    header = reinterpret_cast<FileHeader*>(map);
+    if(!reuse) {
+        std::memset(map,0,headerSize);
+        header->magic = fileMagic;
+        header->version = 1;
+        header->capacity = static_cast<quint64>(capacity);
+        header->head.store(0);
+    }
+    this->capacity = static_cast<quint64>(capacity);
+    reserved.store(header->head.load());
+    ring = map+headerSize;
+}
+
+QString FlightRecorder::defaultFileName()
+{
+    return QCoreApplication::applicationDirPath()+"/blackbox.bin";
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    if(map) {
+        ring = nullptr;
+        file.unmap(map);
+    }
+}
+
+void FlightRecorder::copyIn(uchar *ring, quint64 capacity, quint64 pos, const void *src, quint64 size)
+{
+    quint64 off = pos%capacity;
+    quint64 first = std::min(size,capacity-off);
+    std::memcpy(ring+off,src,first);
+    if(first<size) std::memcpy(ring,static_cast<const uchar*>(src)+first,size-first);
+}
+
+void FlightRecorder::copyOut(const uchar *ring, quint64 capacity, quint64 pos, void *dst, quint64 size)
+{
+    quint64 off = pos%capacity;
+    quint64 first = std::min(size,capacity-off);
+    std::memcpy(dst,ring+off,first);
+    if(first<size) std::memcpy(static_cast<uchar*>(dst)+first,ring,size-first);
+}
+
+void FlightRecorder::append(RecordType type, Direction dir, quint32 ip, const char *data, int size)
+{
+    if(!ring || size<0) return;
+    quint64 total = align(sizeof(RecordHeader)+static_cast<quint64>(size));
+    if(total>capacity/4) return;
+    // место резервируется атомарно, каждый поток пишет в свой участок
+    quint64 pos = reserved.fetch_add(total,std::memory_order_relaxed);
+
+    // признак начала записи ставится последним: читатель не примет недописанную запись
+    std::atomic<quint32> *sync = reinterpret_cast<std::atomic<quint32>*>(ring+pos%capacity);
+    sync->store(0,std::memory_order_relaxed);
+    RecordHeader h;
+    h.sync = 0;
+    h.length = static_cast<quint32>(size);
+    h.time = QDateTime::currentMSecsSinceEpoch();
+    h.ip = ip;
+    h.type = static_cast<quint8>(type);
+    h.direction = static_cast<quint8>(dir);
+    h.crc = static_cast<quint16>(CheckSum::getCRC16(const_cast<char*>(data),size));
+    copyIn(ring,capacity,pos+sizeof(quint32),reinterpret_cast<const uchar*>(&h)+sizeof(quint32),sizeof(RecordHeader)-sizeof(quint32));
+    copyIn(ring,capacity,pos+sizeof(RecordHeader),data,static_cast<quint64>(size));
+    sync->store(recordSync,std::memory_order_release);
+
+    quint64 end = pos+total;
+    quint64 head = header->head.load(std::memory_order_relaxed);
+    while(head<end && !header->head.compare_exchange_weak(head,end,std::memory_order_release,std::memory_order_relaxed));
+}
+
+static void writeWav(const QString &fileName, const QByteArray &pcm)
+{
+    QFile f(fileName);
+    if(!f.open(QIODevice::WriteOnly)) return;
+    QDataStream out(&f);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out.writeRawData("RIFF",4);
+    out << quint32(36+pcm.size());
+    out.writeRawData("WAVEfmt ",8);
+    out << quint32(16) << quint16(1) << quint16(1) << quint32(8000) << quint32(16000) << quint16(2) << quint16(16);
+    out.writeRawData("data",4);
+    out << quint32(pcm.size());
+    out.writeRawData(pcm.constData(),pcm.size());
+}
+
+bool FlightRecorder::dump(const QString &fileName, qint64 from, qint64 to, const QString &outDir)
+{
+    QFile f(fileName);
+    if(!f.open(QIODevice::ReadOnly) || f.size()<=headerSize) return false;
+    const uchar *map = f.map(0,f.size());
+    if(!map) return false;
+    const FileHeader *h = reinterpret_cast<const FileHeader*>(map);
+    if(h->magic!=fileMagic || h->capacity!=static_cast<quint64>(f.size()-headerSize)) return false;
+    const uchar *ring = map+headerSize;
+    quint64 capacity = h->capacity;
+    quint64 head = h->head.load();
+    quint64 pos = head>capacity ? head-capacity : 0;
+
+    QDir dir(outDir);
+    if(!dir.mkpath(".")) return false;
+    QFile packets(dir.filePath("packets.csv"));
+    QFile points(dir.filePath("points.csv"));
+    QFile groups(dir.filePath("groups.csv"));
+    if(!packets.open(QIODevice::WriteOnly) || !points.open(QIODevice::WriteOnly) || !groups.open(QIODevice::WriteOnly)) return false;
+    QTextStream packetsOut(&packets), pointsOut(&points), groupsOut(&groups);
+    packetsOut << "time;ip;direction;data\n";
+    pointsOut << "time;ip;group;point;inp1;inp2;out1;out2;acc;pow;speaker\n";
+    groupsOut << "time;ip;group;points;di1;di2;di3;do1;do2\n";
+
+    // непрерывные фрагменты звука по каждой точке, пауза больше секунды начинает новый файл
+    struct Burst {qint64 start = 0;qint64 last = 0;QByteArray pcm;};
+    std::map<std::tuple<quint32,quint8,quint8>,Burst> bursts;
+    auto flushBurst = [&](const std::tuple<quint32,quint8,quint8> &key, Burst &b) {
+        if(b.pcm.isEmpty()) return;
+        QString name = QString("gr%1_point%2").arg(int(std::get<1>(key))).arg(int(std::get<2>(key)));
+        name += QDateTime::fromMSecsSinceEpoch(b.start).toString("_dd_MM_yyyy_hh_mm_ss_zzz") + ".wav";
+        writeWav(dir.filePath(name),b.pcm);
+        b.pcm.clear();
+    };
+
+    while(pos+sizeof(RecordHeader)<=head) {
+        RecordHeader rh;
+        copyOut(ring,capacity,pos,&rh,sizeof(RecordHeader));
+        quint64 total = align(sizeof(RecordHeader)+rh.length);
+        // начало кольца могло прийтись на середину записи - ищем следующий признак
+        if(rh.sync!=recordSync || total>capacity/4 || pos+total>head) {pos+=8;continue;}
+        QByteArray data(static_cast<int>(rh.length),Qt::Uninitialized);
+        copyOut(ring,capacity,pos+sizeof(RecordHeader),data.data(),rh.length);
+        if(static_cast<quint16>(CheckSum::getCRC16(data.data(),data.size()))!=rh.crc) {pos+=8;continue;}
+        pos += total;
+        if(rh.time<from || rh.time>to) continue;
+
+        QString time = QDateTime::fromMSecsSinceEpoch(rh.time).toString("dd.MM.yyyy hh:mm:ss.zzz");
+        QString ip = QHostAddress(rh.ip).toString();
+        switch(static_cast<RecordType>(rh.type)) {
+            case RecordType::DATAGRAM:
+                packetsOut << time << ";" << ip << ";" << (rh.direction==static_cast<quint8>(Direction::TX)?"TX":"RX") << ";" << data.toHex(' ') << "\n";
+                break;
+            case RecordType::POINT_STATE: {
+                if(data.size()<3) break;
+                int cnt = (data.size()-3)/PointData::getRawDataSize();
+                for(int i=0;i<cnt;i++) {
+                    PointData p(data.mid(3+i*PointData::getRawDataSize(),PointData::getRawDataSize()));
+                    if(p.getGroupNum()==0) continue;
+                    pointsOut << time << ";" << ip << ";" << int(p.getGroupNum()) << ";" << int(p.getPointNum()) << ";"
+                              << p.getInput1String() << ";" << p.getInput2String() << ";"
+                              << p.getOutput1String() << ";" << p.getOutput2String() << ";"
+                              << p.getAccumulatorVoltage() << ";" << p.getPowerVoltage() << ";" << p.getSpeakerString() << "\n";
+                }
+                break;
+            }
+            case RecordType::GROUP_STATE: {
+                int cnt = data.size()/GroupData::getRawGroupDataSize();
+                for(int i=0;i<cnt;i++) {
+                    GroupData g(data.mid(i*GroupData::getRawGroupDataSize(),GroupData::getRawGroupDataSize()));
+                    if(g.getGrNum()==0) continue;
+                    groupsOut << time << ";" << ip << ";" << int(g.getGrNum()) << ";" << int(g.getPointsQuantity()) << ";"
+                              << g.getInput1String() << ";" << g.getInput2String() << ";" << g.getInput3String() << ";"
+                              << g.getOut1String() << ";" << g.getOut2String() << "\n";
+                }
+                break;
+            }
+            case RecordType::AUDIO: {
+                if(data.size()<2) break;
+                auto key = std::make_tuple(rh.ip,static_cast<quint8>(data.at(0)),static_cast<quint8>(data.at(1)));
+                Burst &b = bursts[key];
+                if(!b.pcm.isEmpty() && rh.time-b.last>1000) flushBurst(key,b);
+                if(b.pcm.isEmpty()) b.start = rh.time;
+                b.last = rh.time;
+                b.pcm.append(data.mid(2));
+                break;
+            }
+        }
+    }
+    for(auto &b:bursts) flushBurst(b.first,b.second);
+    return true;
+}
@@ -0,0 +1,68 @@
+#ifndef FLIGHTRECORDER_H
+#define FLIGHTRECORDER_H
+
+#include <QFile>
+#include <QByteArray>
+#include <QString>
+#include <atomic>
+
+// бортовой журнал: последние пакеты обмена со шлюзом, срезы состояния и звук
+// кольцевой буфер в файле, отображённом в память, - данные остаются на диске при аварийном завершении
+class FlightRecorder
+{
+public:
+    enum class Direction : quint8 {TX,RX,LOCAL};
+    enum class RecordType : quint8 {DATAGRAM,POINT_STATE,GROUP_STATE,AUDIO};
+
+    static const qint64 defaultCapacity = 64*1024*1024;
+
+    explicit FlightRecorder(const QString &fileName, qint64 capacity = defaultCapacity);
+    ~FlightRecorder();
+    bool isOpen() const {return ring!=nullptr;}
+    // может вызываться из любого потока без блокировок
+    void append(RecordType type, Direction dir, quint32 ip, const char *data, int size);
+    void append(RecordType type, Direction dir, quint32 ip, const QByteArray &data) {append(type,dir,ip,data.constData(),data.size());}
+
+    static QString defaultFileName();
+
+    // выгрузка интервала [from,to] (мс с начала эпохи): звук в wav, состояние и пакеты в csv
+    static bool dump(const QString &fileName, qint64 from, qint64 to, const QString &outDir);
+
+private:
+    struct FileHeader {
+        quint32 magic;
+        quint32 version;
+        quint64 capacity;
+        std::atomic<quint64> head;      // логическая позиция конца последней записи
+    };
+
+    struct RecordHeader {
+        quint32 sync;
+        quint32 length;
+        qint64 time;
+        quint32 ip;
+        quint8 type;
+        quint8 direction;
+        quint16 crc;
+    };
+
+    static const quint32 fileMagic = 0x42424F58;   // "BBOX"
+    static const quint32 recordSync = 0xB1ACB0C5;
+    static const int headerSize = 4096;
+
+    QFile file;
+    uchar *map = nullptr;
+    FileHeader *header = nullptr;
+    uchar *ring = nullptr;
+    quint64 capacity = 0;
+    std::atomic<quint64> reserved{0};
+
+    static quint64 align(quint64 size) {return (size+7) & ~quint64(7);}
+    static void copyIn(uchar *ring, quint64 capacity, quint64 pos, const void *src, quint64 size);
+    static void copyOut(const uchar *ring, quint64 capacity, quint64 pos, void *dst, quint64 size);
+
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+};
+
+#endif // FLIGHTRECORDER_H
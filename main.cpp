@@ -1,8 +1,49 @@
 #include "mainwindow.h"
+#include "flightrecorder.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDebug>
+
+// выгрузка бортового журнала: GATE --dump-blackbox <каталог> [--from время] [--to время] [--file журнал]
+static int dumpBlackbox(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCommandLineParser parser;
+    QCommandLineOption dumpOption("dump-blackbox", "Output directory.", "dir");
+    QCommandLineOption fileOption("file", "Flight recorder file.", "file", FlightRecorder::defaultFileName());
+    QCommandLineOption fromOption("from", "Window start, yyyy-MM-ddThh:mm:ss.", "time");
+    QCommandLineOption toOption("to", "Window end, yyyy-MM-ddThh:mm:ss.", "time");
+    parser.addOptions({dumpOption, fileOption, fromOption, toOption});
+    parser.process(a);
+
+    // опечатка во времени не должна молча дать выгрузку за другой интервал
+    QDateTime toTime = parser.isSet(toOption) ? QDateTime::fromString(parser.value(toOption), Qt::ISODate) : QDateTime::currentDateTime();
+    if(!toTime.isValid()) {
+        qCritical().noquote() << "Invalid --to value" << parser.value(toOption) << "- expected yyyy-MM-ddThh:mm:ss.";
+        return 2;
+    }
+    qint64 to = toTime.toMSecsSinceEpoch();
+    // по умолчанию - последние 10 минут
+    QDateTime fromTime = parser.isSet(fromOption) ? QDateTime::fromString(parser.value(fromOption), Qt::ISODate) : QDateTime::fromMSecsSinceEpoch(to-600000);
+    if(!fromTime.isValid()) {
+        qCritical().noquote() << "Invalid --from value" << parser.value(fromOption) << "- expected yyyy-MM-ddThh:mm:ss.";
+        return 2;
+    }
+    qint64 from = fromTime.toMSecsSinceEpoch();
+    if(from>to) {
+        qCritical().noquote() << "--from is later than --to.";
+        return 2;
+    }
+    return FlightRecorder::dump(parser.value(fileOption), from, to, parser.value(dumpOption)) ? 0 : 1;
+}
 
 int main(int argc, char *argv[])
 {
+    for(int i=1;i<argc;i++) {
+        if(QString(argv[i]).startsWith("--dump-blackbox")) return dumpBlackbox(argc, argv);
+    }
+
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
@@ -9,13 +9,18 @@
 #include "dialogdate.h"
 #include <QSqlQuery>
 #include <QSqlQueryModel>
-#include "audiotree.h"
 #include <QStringList>
 #include <QStyle>
 #include "dialogvolumeconfig.h"
 #include "dialoginputsconfig.h"
 #include "pointdata.h"
 #include "groupdata.h"
+#include <QDesktopServices>
+#include <QFile>
+#include <QUrl>
+#include <QMenu>
+#include <QStatusBar>
+#include <QHeaderView>
 
 QAudioDeviceInfo MainWindow::getInpDevice(const QString &name)
 {
@@ -51,15 +56,10 @@ void MainWindow::updatePointsList()
 {
   QVBoxLayout *layout = dynamic_cast<QVBoxLayout *>(ui->scrollArea->widget()->layout());
   if (layout) {
-    ui->treeWidget->clear();
-    if(tree!=nullptr) delete tree;
-    tree = new AudioTree(ui->treeWidget, prConfig.get());
-    tree->createTree();
+    prConfig->readConfig();
+    stateModel->setGates(prConfig->gates);
     layout->addStretch(1);
   }
-  ui->treeWidget->expandAll();
-  ui->treeWidget->resizeColumnToContents(0);
-  ui->treeWidget->collapseAll();
   prConfig->readConfig();
   ip1 = prConfig->ip1.toInt();
   ip2 = prConfig->ip2.toInt();
@@ -70,10 +70,7 @@ void MainWindow::updatePointsList()
   setTimerInterval(60*audio_tmr);
   ui->comboBoxGroups->clear();
   for(int i=0;i<grCnt;i++) {
-      auto grName = tree->getGroupValue(i,"name");
-      if(grName) {
-          ui->comboBoxGroups->addItem(std::any_cast<QString>(grName.value()));
-      }
+      ui->comboBoxGroups->addItem(stateModel->groupName(i));
   }
 }
 
@@ -103,13 +100,17 @@ void MainWindow::updateAlarmList(const QStringList &list)
 
 MainWindow::MainWindow(QWidget *parent): QMainWindow(parent), ui(new Ui::MainWindow) {
 
-  tree = nullptr;
+  stateModel = new StateModel(this);
 
   prConfig = std::make_unique<ProjectConfig>("conf.json");
+  blackbox = std::make_unique<FlightRecorder>(FlightRecorder::defaultFileName());
 
   QTextCodec *utfcodec = QTextCodec::codecForName("UTF-8");
   QTextCodec::setCodecForLocale(utfcodec);
   ui->setupUi(this);
+  // дерево читает поля точек из модели только для раскрытых и видимых строк
+  ui->treeView->setModel(stateModel);
+  ui->treeView->header()->setSectionResizeMode(0,QHeaderView::ResizeToContents);
 
   fromDate = QDate::currentDate();
   toDate = QDate::currentDate();
@@ -124,10 +125,19 @@ MainWindow::MainWindow(QWidget *parent): QMainWindow(parent), ui(new Ui::MainWin
   speakerTimer = nullptr;
   udpScanner = nullptr;
 
-  recorder = new MP3Recorder();
+  transcodePool = new TranscodePool(this);
+  recorder = new MP3Recorder(transcodePool);
+  recordManager = new RecordManager(transcodePool);
   manager = new SQLManager();
   connect(manager,&SQLManager::error,this,&MainWindow::sqlError);
   connect(manager,&SQLManager::updateAlarmList,this,&MainWindow::updateAlarmList);
+  connect(manager,&SQLManager::metrics,this,&MainWindow::sqlMetrics);
+  sqlStatus = new QLabel(this);
+  statusBar()->addPermanentWidget(sqlStatus);
+  connect(recordManager,&RecordManager::recordReady,manager,&SQLManager::insertRecord);
+  manager->setDBSettings(prConfig->db);
+  manager->setArchiveMonths(prConfig->archiveMonths);
+  manager->setReportSettings(prConfig->report);
   manager->initDB();
   manager->insertMessage("Запуск приложения","сообщение");
 
@@ -163,39 +173,32 @@ MainWindow::MainWindow(QWidget *parent): QMainWindow(parent), ui(new Ui::MainWin
     ip += QString::number(static_cast<quint8>(ip3)) + ".";
     ip += QString::number(static_cast<quint8>(ip4));
     manager->setIP(ip);
-    udpScanner = new UDPController(ip);
+    gateIp = ip;
+    recordManager->setGate(ip);
+    udpScanner = new UDPController(ip, blackbox.get());
     udpScanner->setToID(static_cast<quint8>(linkGroup),static_cast<quint8>(linkPoint));
 
 
-    for(int i = 0; i < 1000; i++)
-    {
-       x.append(i);
-       y.append(0);
-       x2.append(i);
-       y2.append(0);
-    }
-
-    ui->widget->xAxis->setTickLabels(false);
-    ui->widget->yAxis->setTickLabels(false);
-    ui->widget->addGraph();
-    ui->widget->graph(0)->setData(x,y);
-    ui->widget->xAxis->setRange(0, 1000);
-    ui->widget->yAxis->setRange(-1, 1);
-    ui->widget->replot();
-
-    ui->widget_out->xAxis->setTickLabels(false);
-    ui->widget_out->yAxis->setTickLabels(false);
-    ui->widget_out->addGraph();
-    ui->widget_out->graph(0)->setData(x2, y2);
-    ui->widget_out->xAxis->setRange(0, 1000);
-    ui->widget_out->yAxis->setRange(-1, 1);
-    ui->widget_out->replot();
+    inScope = std::make_unique<ScopeBuffer>(ui->widget);
+    outScope = std::make_unique<ScopeBuffer>(ui->widget_out);
+    // звук и состояние точек приходят чаще кадров - графики и дерево обновляются с постоянной частотой
+    frameTimer = new QTimer(this);
+    connect(frameTimer, &QTimer::timeout, this, [this](){
+        inScope->replot();
+        outScope->replot();
+        stateModel->flush();
+    });
+    frameTimer->start(framePeriodMs);
 
     connect(udpScanner, &UDPController::linkStateChanged,this,&MainWindow::linkStatechanged);
     connect(udpScanner, &UDPController::fromIDSignal,this,&MainWindow::fromIDChanged);
     connect(udpScanner, &UDPController::updateState,this,&MainWindow::updateState);
     connect(udpScanner, &UDPController::updateGroupState,this,&MainWindow::updateGroupState);
     connect(udpScanner, &UDPController::startRecord,this,&MainWindow::startRecord);
+    // запись звука не зависит от очереди событий окна: модальный диалог не задерживает кадры
+    connect(udpScanner->audioSource(), &UDPWorker::startRecord, recordManager, &RecordManager::startRecord, Qt::DirectConnection);
+    connect(udpScanner->audioSource(), &UDPWorker::recordAudio, recordManager, &RecordManager::recordAudio, Qt::DirectConnection);
+    connect(udpScanner->audioSource(), &UDPWorker::stopRecord, recordManager, &RecordManager::stopRecord, Qt::DirectConnection);
     connect(udpScanner, &UDPController::stopRecord,this,&MainWindow::stopRecord);
 
     ui->pushButtonStartStop->setStyleSheet("QPushButton{ background-color :lightgray;}");
@@ -218,20 +221,17 @@ MainWindow::MainWindow(QWidget *parent): QMainWindow(parent), ui(new Ui::MainWin
     ui->toolBar->addAction(QIcon(":/images/volume.png"),"Громкость точек",[this](){
         if (buttonCmd == ButtonState::STOP) {
             DialogVolumeConfig *dialog = new DialogVolumeConfig();
-            if(tree!=nullptr) {
+            if(stateModel->groupCount()) {
                 QStringList groups;
-                int gateCnt = static_cast<int>(prConfig->gates.size());
+                int gateCnt = stateModel->groupCount();
                 for(int i=0;i<gateCnt;i++) {
-                    auto grName = tree->getGroupValue(i,"name");
-                    if(grName) groups.append(std::any_cast<QString>(grName.value()));
-                    quint8 point_cnt = static_cast<quint8>(prConfig->gates.at(static_cast<std::size_t>(i)).points.size());
+                    groups.append(stateModel->groupName(i));
+                    int point_cnt = stateModel->pointCount(i);
                     QStringList points;
                     QStringList volumes;
                     for(int j=0;j<point_cnt;j++) {
-                        auto pointName = tree->getPointValue(i,j,"name");
-                        if(pointName) points.append(std::any_cast<QString>(pointName.value()));
-                        auto volume = tree->getPointValue(i,j,"volume");
-                        if(volume) volumes.append(std::any_cast<QString>(volume.value()));
+                        points.append(stateModel->pointName(i,j));
+                        volumes.append(stateModel->pointText(i,j,PointField::VOLUME));
                     }
                     dialog->addPoints(points);
                     dialog->addVolume(volumes);
@@ -261,29 +261,19 @@ MainWindow::MainWindow(QWidget *parent): QMainWindow(parent), ui(new Ui::MainWin
     ui->toolBar->addAction(QIcon(":/images/contact.png"),"Фильтр входов точек",[this](){
         if (buttonCmd == ButtonState::STOP) {
             DialogInputsConfig *dialog = new DialogInputsConfig();
-            if(tree!=nullptr) {
-                int gateCnt = static_cast<int>(prConfig->gates.size());
+            if(stateModel->groupCount()) {
+                int gateCnt = stateModel->groupCount();
                 for(int i=0;i<gateCnt;i++) {
                     GateConf conf;
-                    auto grName = tree->getGroupValue(i,"name");
-                    if(grName) conf.name = std::any_cast<QString>(grName.value());
-                    quint8 point_cnt = static_cast<quint8>(prConfig->gates.at(static_cast<std::size_t>(i)).points.size());
+                    conf.name = stateModel->groupName(i);
+                    int point_cnt = stateModel->pointCount(i);
                     for(int j=0;j<point_cnt;j++) {
                         PointConf pConf;
-                        auto pointName = tree->getPointValue(i,j,"name");
-                        if(pointName) pConf.name = std::any_cast<QString>(pointName.value());
-                        auto inp1 = tree->getPointValue(i,j,"di1");
-                        auto inp2 = tree->getPointValue(i,j,"di2");
-                        auto filter1 = tree->getPointValue(i,j,"di1_filter");
-                        auto filter2 = tree->getPointValue(i,j,"di2_filter");
-                        auto inp1Value = std::any_cast<Input>(inp1.value());
-                        if(inp1Value!=Input::UNUSED) pConf.inp1En=true;else pConf.inp1En=false;
-                        auto inp2Value = std::any_cast<Input>(inp2.value());
-                        if(inp2Value!=Input::UNUSED) pConf.inp2En=true;else pConf.inp2En=false;
-                        auto filter1Value = std::any_cast<double>(filter1.value());
-                        pConf.in1Filter = static_cast<quint8>(filter1Value*2);
-                        auto filter2Value = std::any_cast<double>(filter2.value());
-                        pConf.in2Filter = static_cast<quint8>(filter2Value*2);
+                        pConf.name = stateModel->pointName(i,j);
+                        pConf.inp1En = stateModel->pointValue<PointField::DI1>(i,j)!=Input::UNUSED;
+                        pConf.inp2En = stateModel->pointValue<PointField::DI2>(i,j)!=Input::UNUSED;
+                        pConf.in1Filter = static_cast<quint8>(stateModel->pointValue<PointField::DI1_FILTER>(i,j)*2);
+                        pConf.in2Filter = static_cast<quint8>(stateModel->pointValue<PointField::DI2_FILTER>(i,j)*2);
                         conf.points.push_back(pConf);
                     }
                     dialog->addGateConf(conf);
@@ -335,6 +325,10 @@ MainWindow::MainWindow(QWidget *parent): QMainWindow(parent), ui(new Ui::MainWin
 
 MainWindow::~MainWindow()
 {
+    // поток обмена останавливается до закрытия бортового журнала
+    delete udpScanner;
+    // менеджер записи отдаёт последние фрагменты в пул конвертации до его удаления
+    delete recordManager;
     delete ui;
 }
 
@@ -385,6 +379,8 @@ void MainWindow::on_pushButtonStartStop_clicked()
         QString ip = QString::number(ip1)+"."+QString::number(ip2)+"."+QString::number(ip3)+"."+QString::number(ip4);
         udpScanner->setIP(ip);
         manager->setIP(ip);
+        gateIp = ip;
+        recordManager->setGate(ip);
         udpScanner->start();
         linkState = false;
         QTimer::singleShot(3000, this, [this](){
@@ -417,6 +413,7 @@ void MainWindow::on_pushButtonStartStop_clicked()
         ui->comboBoxOut->setEnabled(true);
 
         udpScanner->stop();
+        recordManager->stopAll();
 
 
         ui->pushButtonStartStop->setStyleSheet("QPushButton{ background-color :lightgray; }");
@@ -430,22 +427,12 @@ void MainWindow::on_pushButtonStartStop_clicked()
 
 void MainWindow::newLevel(const QVector<double> &inp)
 {
-    for(const auto v: inp) {
-        y.pop_front();
-        y.append(v);
-    }
-    ui->widget->graph(0)->setData(x, y);
-    ui->widget->replot();
+    inScope->append(inp);
 }
 
 void MainWindow::newOutLevel(const QVector<double> &inp)
 {
-  for (const auto v : inp) {
-    y2.pop_front();
-    y2.append(v);
-  }
-  ui->widget_out->graph(0)->setData(x2, y2);
-  ui->widget_out->replot();
+  outScope->append(inp);
 }
 
 void MainWindow::linkStatechanged(bool value)
@@ -494,114 +481,46 @@ void MainWindow::updateState(const QByteArray state)
             quint8 grNum = p.getGroupNum();
             quint8 pointNum = p.getPointNum();
             if(grNum && pointNum) {
-                QString inp2TypeStr;
                 Inp2Type inp2type = p.getInput2Type();
-                if(inp2type==Inp2Type::KSL) inp2TypeStr = "КСЛ";
-                else if(inp2type==Inp2Type::FENCE) inp2TypeStr = "ПЕРЕЕЗД";
-                else if(inp2type==Inp2Type::JAMMING) inp2TypeStr = "ОГРАЖДЕНИЕ";
-                else if(inp2type==Inp2Type::CROSSING) inp2TypeStr = "ЗАШТЫБОВКА";
+                const QString &inp2TypeStr = StateModel::inp2TypeText(inp2type);
 
-                tree->setPointValue(grNum-1,pointNum-1,"di2_type",inp2TypeStr);
+                int g = grNum-1, n = pointNum-1;
+                stateModel->setPoint<PointField::DI2_TYPE>(g,n,inp2type);
+                stateModel->setPoint<PointField::VERSION>(g,n,p.getVersion());
+                stateModel->setPoint<PointField::VOLUME>(g,n,p.getSoundReduction());
 
-                quint8 vers = p.getVersion();
-                if(vers<=200) tree->setPointValue(grNum-1,pointNum-1,"version",QString::number(vers)+QString(".0"));
-                else tree->setPointValue(grNum-1,pointNum-1,"version","Загрузчик " + QString::number(vers-200)+QString(".0"));
-                quint8 volume = p.getSoundReduction();
-                if(volume==0) tree->setPointValue(grNum-1,pointNum-1,"volume",QString("максимум"));
-                else if(volume>3) tree->setPointValue(grNum-1,pointNum-1,"volume",QString("некорректное значение") + QString::number(volume));
-                else tree->setPointValue(grNum-1,pointNum-1,"volume",QString("1/")+QString::number(pow(2,volume)));
-
-                auto grName = tree->getGroupValue(grNum-1,"name");
-                auto pointName = tree->getPointValue(grNum-1,pointNum-1,"name");
+                // точки вне конфигурации в список тревог не попадают
+                bool named = n<stateModel->pointCount(g);
+                QString alarmText = stateModel->alarmPrefix(g,n);
 
                 Input di1 = p.getInput1();
-                tree->setPointValue(grNum-1,pointNum-1,"di1",di1);
-                if(di1!=Input::UNUSED) {
-                    if(di1==Input::BREAK) {
-                        if(grName) {
-                            QString alarmText = std::any_cast<QString>(grName.value())+" ";
-                            if(pointName) {
-                                alarmText += std::any_cast<QString>(pointName.value())+": ";
-                                alarmText += "АВАРИЯ ВХОД1(КТВ) - ОБРЫВ";
-                                alarmPointList.append(alarmText);
-                            }
-                        }
-                    }else if(di1==Input::SHORT) {
-                        if(grName) {
-                            QString alarmText = std::any_cast<QString>(grName.value())+" ";
-                            if(pointName) {
-                                alarmText += std::any_cast<QString>(pointName.value())+": ";
-                                alarmText += "АВАРИЯ ВХОД1(КТВ) - ЗАМЫКАНИЕ";
-                                alarmPointList.append(alarmText);
-                            }
-                        }
-                    }else if(di1==Input::OFF) {
-                        if(grName) {
-                            QString alarmText = std::any_cast<QString>(grName.value())+" ";
-                            if(pointName) {
-                                alarmText += std::any_cast<QString>(pointName.value())+": ";
-                                alarmText += "АВАРИЯ ВХОД1(КТВ) - ВЫКЛ";
-                                alarmPointList.append(alarmText);
-                            }
-                        }
-                    }
+                stateModel->setPoint<PointField::DI1>(g,n,di1);
+                if(named && di1!=Input::UNUSED) {
+                    if(di1==Input::BREAK) alarmPointList.append(alarmText + "АВАРИЯ ВХОД1(КТВ) - ОБРЫВ");
+                    else if(di1==Input::SHORT) alarmPointList.append(alarmText + "АВАРИЯ ВХОД1(КТВ) - ЗАМЫКАНИЕ");
+                    else if(di1==Input::OFF) alarmPointList.append(alarmText + "АВАРИЯ ВХОД1(КТВ) - ВЫКЛ");
                 }
 
                 Input di2 = p.getInput2();
-                tree->setPointValue(grNum-1,pointNum-1,"di2",di2);
-                if(di2!=Input::UNUSED) {
-                    if(di2==Input::BREAK) {
-                        if(grName) {
-                            QString alarmText = std::any_cast<QString>(grName.value())+" ";
-                            if(pointName) {
-                                alarmText += std::any_cast<QString>(pointName.value())+": ";
-                                alarmText += "АВАРИЯ ВХОД2(" + inp2TypeStr + ") - ОБРЫВ";
-                                alarmPointList.append(alarmText);
-                            }
-                        }
-                    }else if(di2==Input::SHORT) {
-                        if(grName) {
-                            QString alarmText = std::any_cast<QString>(grName.value())+" ";
-                            if(pointName) {
-                                alarmText += std::any_cast<QString>(pointName.value())+": ";
-                                alarmText += "АВАРИЯ ВХОД2(" + inp2TypeStr + ") - ЗАМЫКАНИЕ";
-                                alarmPointList.append(alarmText);
-                            }
-                        }
-                    }else if(di2==Input::OFF) {
-                        if(grName) {
-                            QString alarmText = std::any_cast<QString>(grName.value())+" ";
-                            if(pointName) {
-                                alarmText += std::any_cast<QString>(pointName.value())+": ";
-                                alarmText += "АВАРИЯ ВХОД2(" + inp2TypeStr + ") - ВЫКЛ";
-                                alarmPointList.append(alarmText);
-                            }
-                        }
-                    }
+                stateModel->setPoint<PointField::DI2>(g,n,di2);
+                if(named && di2!=Input::UNUSED) {
+                    if(di2==Input::BREAK) alarmPointList.append(alarmText + "АВАРИЯ ВХОД2(" + inp2TypeStr + ") - ОБРЫВ");
+                    else if(di2==Input::SHORT) alarmPointList.append(alarmText + "АВАРИЯ ВХОД2(" + inp2TypeStr + ") - ЗАМЫКАНИЕ");
+                    else if(di2==Input::OFF) alarmPointList.append(alarmText + "АВАРИЯ ВХОД2(" + inp2TypeStr + ") - ВЫКЛ");
                 }
 
-
-                tree->setPointValue(grNum-1,pointNum-1,"do1",p.getOutput1());
-                tree->setPointValue(grNum-1,pointNum-1,"do2",p.getOutput2());
-                tree->setPointValue(grNum-1,pointNum-1,"limit_switch",p.getLastPointSwitch());
-                tree->setPointValue(grNum-1,pointNum-1,"di1_filter",p.getDI1Filter());
-                tree->setPointValue(grNum-1,pointNum-1,"di2_filter",p.getDI2Filter());
+                stateModel->setPoint<PointField::DO1>(g,n,p.getOutput1());
+                stateModel->setPoint<PointField::DO2>(g,n,p.getOutput2());
+                stateModel->setPoint<PointField::LIMIT_SWITCH>(g,n,p.getLastPointSwitch());
+                stateModel->setPoint<PointField::DI1_FILTER>(g,n,p.getDI1Filter());
+                stateModel->setPoint<PointField::DI2_FILTER>(g,n,p.getDI2Filter());
 
                 auto speaker = p.getSpeaker();
-                tree->setPointValue(grNum-1,pointNum-1,"speaker",speaker);
-                if(speaker==Speaker::PROBLEM) {
-                    if(grName) {
-                        QString alarmText = std::any_cast<QString>(grName.value())+" ";
-                        if(pointName) {
-                            alarmText += std::any_cast<QString>(pointName.value())+": ";
-                            alarmText += "АВАРИЯ НЕИСПРАВНОСТЬ ДИНАМИКОВ";
-                            alarmPointList.append(alarmText);
-                        }
-                    }
-                }
+                stateModel->setPoint<PointField::SPEAKER>(g,n,speaker);
+                if(named && speaker==Speaker::PROBLEM) alarmPointList.append(alarmText + "АВАРИЯ НЕИСПРАВНОСТЬ ДИНАМИКОВ");
 
-                tree->setPointValue(grNum-1,pointNum-1,"power",p.getPowerVoltage());
-                tree->setPointValue(grNum-1,pointNum-1,"battery",p.getAccumulatorVoltage());
+                stateModel->setPoint<PointField::POWER>(g,n,p.getPowerVoltage());
+                stateModel->setPoint<PointField::BATTERY>(g,n,p.getAccumulatorVoltage());
             }
         }
     }
@@ -637,29 +556,27 @@ void MainWindow::updateGroupState(const QByteArray state)
             quint8 grNum = grData.getGrNum();
             if(grNum) {
                 quint8 cnt = grData.getPointsQuantity();
-                tree->setGroupValue(i,"real_point_cnt",static_cast<int>(cnt));
-                if(cnt<tree->pointCount(i)) {
-                    auto grName = tree->getGroupValue(i,"name");
-                    alarmGroupList.append(std::any_cast<QString>(grName.value()) + ":");
+                stateModel->setGroup<GroupField::POINT_CNT>(i,cnt);
+                if(cnt<stateModel->pointCount(i)) {
+                    alarmGroupList.append(stateModel->groupName(i) + ":");
                     alarmGroupList.append("АВАРИЯ: Число подключенных точек - " + QString::number(cnt));
-                    alarmGroupList.append("ожидается " + QString::number(tree->pointCount(i)));
+                    alarmGroupList.append("ожидается " + QString::number(stateModel->pointCount(i)));
                     alarmGroupList.append("");
-                    for(int j=cnt;j<tree->pointCount(i);j++) {
-                        tree->setPointToDefault(i,j);
+                    for(int j=cnt;j<stateModel->pointCount(i);j++) {
+                        stateModel->setPointToDefault(i,j);
                     }
                 }
-                tree->setGroupValue(i,"di1",grData.getInput1());
-                tree->setGroupValue(i,"di2",grData.getInput2());
-                tree->setGroupValue(i,"di3",grData.getInput3());
-                tree->setGroupValue(i,"do1",grData.getOut1());
-                tree->setGroupValue(i,"do2",grData.getOut2());
-                tree->setGroupValue(i,"not_actual",grData.getNotActual());
+                stateModel->setGroup<GroupField::DI1>(i,grData.getInput1());
+                stateModel->setGroup<GroupField::DI2>(i,grData.getInput2());
+                stateModel->setGroup<GroupField::DI3>(i,grData.getInput3());
+                stateModel->setGroup<GroupField::DO1>(i,grData.getOut1());
+                stateModel->setGroup<GroupField::DO2>(i,grData.getOut2());
+                stateModel->setNotActual(i,grData.getNotActual());
             }else {
-                if(tree->pointCount(i)) {
-                    auto grName = tree->getGroupValue(i,"name");
-                    alarmGroupList.append(std::any_cast<QString>(grName.value()) + ":");
+                if(stateModel->pointCount(i)) {
+                    alarmGroupList.append(stateModel->groupName(i) + ":");
                     alarmGroupList.append("АВАРИЯ: Число подключенных точек - не известно");
-                    alarmGroupList.append("ожидается " + QString::number(tree->pointCount(i)));
+                    alarmGroupList.append("ожидается " + QString::number(stateModel->pointCount(i)));
                     alarmGroupList.append("");
                 }
             }
@@ -674,29 +591,61 @@ void MainWindow::checkAudio()
 
 void MainWindow::startRecord(uint8_t gr, uint8_t point)
 {
-    m_audiOutputDevice->startRecordCmd(gr,point);
     //qDebug() << gr << point;
     QString res;
     if(gr && point) {
-        auto grName = tree->getGroupValue(gr-1,"name");
-        auto pointName = tree->getPointValue(gr-1,point-1,"name");
-        if(grName && pointName) {
-            res+= std::any_cast<QString>(grName.value()) + "   (" + std::any_cast<QString>(pointName.value())+")";
+        if(point<=stateModel->pointCount(gr-1)) {
+            res+= stateModel->groupName(gr-1) + "   (" + stateModel->pointName(gr-1,point-1)+")";
             ui->lineEditInputPoint->setText(res);
         }
     }
 
 }
 
-void MainWindow::stopRecord()
+void MainWindow::stopRecord(uint8_t gr, uint8_t point)
 {
-    m_audiOutputDevice->stopRecordCmd();
+    Q_UNUSED(gr)
+    Q_UNUSED(point)
     ui->lineEditInputPoint->setText("");
 }
 
 void MainWindow::sqlError(const QString &message)
 {
-    QMessageBox::critical(nullptr, tr("VOIP ДИспетчер"),message);
+    // окно ошибки базы одно и не блокирует работу, следующая ошибка заменяет текст
+    if(!sqlErrorBox) {
+        sqlErrorBox = new QMessageBox(QMessageBox::Critical,tr("VOIP ДИспетчер"),QString(),QMessageBox::Ok,this);
+        sqlErrorBox->setModal(false);
+    }
+    sqlErrorBox->setText(message);
+    sqlErrorBox->show();
+}
+
+void MainWindow::sqlMetrics(const SQLMetrics &m)
+{
+    QString text = "БД: очередь " + QString::number(m.frameQueue) + "/" + QString::number(m.messageQueue);
+    text += ", задержка " + QString::number(m.lagMs) + " мс";
+    text += ", записей " + QString::number(m.rows) + ", транзакций " + QString::number(m.commits);
+    if(m.writeMaxMs) text += ", запись " + QString::number(m.writeAvgMs) + "/" + QString::number(m.writeMaxMs) + " мс";
+    if(m.archiveQueries) text += " (запросов архива " + QString::number(m.archiveQueries) + ")";
+    if(m.coalescedFrames || m.droppedMessages) {
+        text += ", пропущено кадров " + QString::number(m.coalescedFrames) + ", сообщений " + QString::number(m.droppedMessages);
+    }
+    if(!m.connected) text += ", НЕТ СВЯЗИ";
+    if(m.spoolBytes) text += ", локальный журнал " + QString::number(m.spoolBytes/1024) + " КБ";
+    if(m.replayRate) text += ", перенос " + QString::number(m.replayRate) + " строк/с";
+    if(m.rejectedRows) text += ", пропущено строк с ошибкой " + QString::number(m.rejectedRows);
+    if(m.filteredRows) text += ", отброшено строк точек " + QString::number(m.filteredRows);
+    text += ", ячеек дерева обновлено " + QString::number(stateModel->getUpdatedCells());
+    if(m.alarmChecks) text += ", тревог записано " + QString::number(m.alarmRows) + " из " + QString::number(m.alarmChecks);
+    sqlStatus->setText(text);
+}
+
+void MainWindow::on_listWidgetAlarm_itemDoubleClicked(QListWidgetItem *item)
+{
+    Q_UNUSED(item)
+    // квитирование всех активных тревог: отметка в журнале тревог и отключение звука
+    manager->acknowledgeAlarms();
+    sound->stop();
 }
 
 void MainWindow::radioButton_toggled(bool checked)
@@ -713,12 +662,12 @@ void MainWindow::radioButton_toggled(bool checked)
 
 void MainWindow::on_pushButtonCloseTree_clicked()
 {
-    ui->treeWidget->collapseAll();
+    ui->treeView->collapseAll();
 }
 
 void MainWindow::on_pushButtonOpenTree_clicked()
 {
-    ui->treeWidget->expandAll();
+    ui->treeView->expandAll();
 }
 
 void MainWindow::on_pushButtonCheckAudio_clicked()
@@ -744,6 +693,9 @@ void MainWindow::on_pushButtonJournal_clicked()
     }else if(num==4) {
         manager->updateGroupAlarmArchive(fromDate,toDate,ui->tableViewGroupAlarm,ui->spinBoxGroup->value());
         ui->tableViewGroupAlarm->show();
+    }else if(num==5) {
+        manager->updateRecordArchive(fromDate,toDate,ui->tableViewRecords,ui->spinBoxGroup->value(),ui->spinBoxPoint->value());
+        ui->tableViewRecords->show();
     }
 
 }
@@ -831,9 +783,9 @@ void MainWindow::on_comboBoxGroups_currentIndexChanged(int index)
         if(index>=0) {
             int pointCnt = static_cast<int>(prConfig->gates.at(static_cast<std::size_t>(index)).points.size());
             for(int i=0;i<pointCnt;i++) {
-                auto pointName = tree->getPointValue(ui->comboBoxGroups->currentIndex(),i,"name");
-                if(pointName) {
-                    QRadioButton *rb = new QRadioButton(std::any_cast<QString>(pointName.value()));
+                int group = ui->comboBoxGroups->currentIndex();
+                if(i<stateModel->pointCount(group)) {
+                    QRadioButton *rb = new QRadioButton(stateModel->pointName(group,i));
                     connect(rb, &QRadioButton::toggled, [=](){
                         if(ui->radioButtonPoint->isChecked()) {
                             linkGroup = ui->comboBoxGroups->currentIndex()+1;linkPoint = i+1;
@@ -908,3 +860,29 @@ void MainWindow::on_checkBoxSound_clicked()
     }
 }
 
+void MainWindow::on_tableViewRecords_doubleClicked(const QModelIndex &index)
+{
+    // последний столбец каталога - путь к файлу записи
+    QString fName = index.sibling(index.row(),4).data().toString();
+    if(QFile::exists(fName)) QDesktopServices::openUrl(QUrl::fromLocalFile(fName));
+}
+
+void MainWindow::on_tableViewRecords_clicked(const QModelIndex &index)
+{
+    QString fName = index.sibling(index.row(),4).data().toString();
+    if(QFile::exists(fName)) ui->widgetWaveform->setRecord(fName);
+}
+
+void MainWindow::on_tableViewRecords_customContextMenuRequested(const QPoint &pos)
+{
+    QModelIndex index = ui->tableViewRecords->indexAt(pos);
+    if(!index.isValid()) return;
+    QString fName = index.sibling(index.row(),4).data().toString();
+    if(!QFile::exists(fName)) return;
+    // экспорт выполняется в пуле конвертации, исходная запись сохраняется
+    QMenu menu(this);
+    for(const QString &format:QStringList() << "wav" << "ogg" << "flac") {
+        menu.addAction("Экспорт в "+format.toUpper(),this,[=](){transcodePool->exportRecord(fName,format);});
+    }
+    menu.exec(ui->tableViewRecords->viewport()->mapToGlobal(pos));
+}
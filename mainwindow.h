@@ -7,12 +7,18 @@
 #include <QScopedPointer>
 #include <udpcontroller.h>
 #include <QRadioButton>
+#include <QLabel>
+#include <QListWidgetItem>
+#include <QMessageBox>
 #include "sqlmanager.h"
-#include "audiotree.h"
+#include "statemodel.h"
 #include <QSound>
 #include <QTimer>
 #include "mp3recorder.h"
+#include "recordmanager.h"
 #include "projectconfig.h"
+#include "flightrecorder.h"
+#include "scopebuffer.h"
 #include <memory>
 
 namespace Ui {
@@ -30,7 +36,7 @@ class MainWindow : public QMainWindow
     ButtonState buttonCmd = ButtonState::START;
 
     QTimer *speakerTimer;
-    AudioTree *tree;
+    StateModel *stateModel;
 
     QSound *sound;
 
@@ -47,6 +53,7 @@ class MainWindow : public QMainWindow
     QDate toDate;
 
     std::unique_ptr<ProjectConfig> prConfig;
+    std::unique_ptr<FlightRecorder> blackbox;
 
     qint64 alarmStartTime;
     bool alarmFlag = false;
@@ -57,8 +64,10 @@ class MainWindow : public QMainWindow
 
 
 
-    QVector<double> x, y;
-    QVector<double> x2, y2;
+    std::unique_ptr<ScopeBuffer> inScope;
+    std::unique_ptr<ScopeBuffer> outScope;
+    QTimer *frameTimer;
+    static const int framePeriodMs = 33;    // ~30 кадров/с
 
     std::vector<QRadioButton*> points;
     int point_cnt;
@@ -70,6 +79,7 @@ class MainWindow : public QMainWindow
 
 
     int ip1,ip2,ip3,ip4;
+    QString gateIp;
     QStringList alarmGroupList;
     QStringList alarmPointList;
 
@@ -78,6 +88,10 @@ class MainWindow : public QMainWindow
 
     SQLManager *manager;
     MP3Recorder *recorder;
+    RecordManager *recordManager;
+    TranscodePool *transcodePool;
+    QLabel *sqlStatus;
+    QMessageBox *sqlErrorBox = nullptr;
 
 public:
     explicit MainWindow(QWidget *parent = nullptr);
@@ -94,8 +108,10 @@ private slots:
     void updateGroupState(const QByteArray state);
     void checkAudio();
     void startRecord(uint8_t gr, uint8_t point);
-    void stopRecord();
+    void stopRecord(uint8_t gr, uint8_t point);
     void sqlError(const QString &message);
+    void sqlMetrics(const SQLMetrics &m);
+    void on_listWidgetAlarm_itemDoubleClicked(QListWidgetItem *item);
 
 void radioButton_toggled(bool checked);
 void on_pushButtonCloseTree_clicked();
@@ -113,6 +129,9 @@ void on_radioButtonGroup_clicked();
 void on_pushButtonMicrophone_pressed();
 void on_pushButtonMicrophone_released();
 void on_checkBoxSound_clicked();
+void on_tableViewRecords_doubleClicked(const QModelIndex &index);
+void on_tableViewRecords_clicked(const QModelIndex &index);
+void on_tableViewRecords_customContextMenuRequested(const QPoint &pos);
 
 private:
     Ui::MainWindow *ui;
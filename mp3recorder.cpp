@@ -1,13 +1,12 @@
 #include "mp3recorder.h"
 #include <QFile>
-#include <QDir>
 #include <QCoreApplication>
 #include <QTimer>
 #include <QAudioEncoderSettings>
 #include <QDateTime>
 #include <QUrl>
 
-MP3Recorder::MP3Recorder(QObject *parent) : QObject(parent)
+MP3Recorder::MP3Recorder(TranscodePool *pool, QObject *parent) : QObject(parent), pool(pool)
 {
     dispRecorder = nullptr;
 }
@@ -24,16 +23,13 @@ void MP3Recorder::stopRecord()
             outName.remove(".mp3");
             outName+="_again.mp3";
         }
-        QProcess *process = new QProcess;
-        QDir dir(QCoreApplication::applicationDirPath());
-        process->setProgram(dir.absolutePath()+"/utils/ffmpeg.exe");
-        process->setArguments(QStringList() << "-loglevel" << "fatal" << "-i" << inpName << "-codec:a" << "libmp3lame" << "-qscale:a" << "5" << outName);
-        process->start();
-        procs.append(process);
-        wafFiles.append(inpName);
-
-        QTimer::singleShot(10000, this, [=](){if(!procs.isEmpty()) {QProcess* pr = procs.pop();pr->kill();delete pr;}
-            if(!wafFiles.isEmpty()){QString file = wafFiles.pop();if(QFile::exists(file)) QFile::remove(file);}});
+        TranscodeJob job;
+        job.source = inpName;
+        job.target = outName;
+        job.inputArguments << "-loglevel" << "fatal";
+        job.arguments << "-codec:a" << "libmp3lame" << "-qscale:a" << "5";
+        job.tag = "dispatcher";
+        pool->enqueue(job);
 
         dispRecorder = nullptr;
     }
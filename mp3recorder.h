@@ -2,21 +2,19 @@
 #define MP3RECORDER_H
 
 #include <QObject>
-#include <QStack>
-#include <QProcess>
 #include <QString>
 #include <QAudioRecorder>
+#include "transcodepool.h"
 
 
 class MP3Recorder : public QObject
 {
     Q_OBJECT
 public:
-    explicit MP3Recorder(QObject *parent = nullptr);
+    explicit MP3Recorder(TranscodePool *pool, QObject *parent = nullptr);
 private:
     QString fName;
-    QStack<QProcess*> procs;
-    QStack<QString> wafFiles;
+    TranscodePool *pool;
     qint64 startTime;
     QAudioRecorder *dispRecorder;
     QString audioInputName;
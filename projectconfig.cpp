@@ -38,6 +38,49 @@ bool ProjectConfig::readConfig()
         if(loadOb.contains("audio tmr")) {
             tmr = loadOb["audio tmr"].toString();
         }
+        if(loadOb.contains("db driver")) {
+            db.driver = loadOb["db driver"].toString();
+        }
+        if(loadOb.contains("db host")) {
+            db.host = loadOb["db host"].toString();
+        }
+        if(loadOb.contains("db port")) {
+            db.port = loadOb["db port"].toInt(db.port);
+        }
+        if(loadOb.contains("db name")) {
+            db.name = loadOb["db name"].toString();
+        }
+        if(loadOb.contains("db user")) {
+            db.user = loadOb["db user"].toString();
+        }
+        if(loadOb.contains("db password")) {
+            db.password = loadOb["db password"].toString();
+        }
+        if(loadOb.contains("db file")) {
+            db.file = loadOb["db file"].toString();
+        }
+        if(loadOb.contains("archive months")) {
+            archiveMonths = loadOb["archive months"].toInt(archiveMonths);
+        }
+        // зоны нечувствительности в конфигурации в вольтах
+        if(loadOb.contains("pow deadband")) {
+            report.pow.deadband = qRound(loadOb["pow deadband"].toDouble(report.pow.deadband/10.0)*10);
+        }
+        if(loadOb.contains("pow hysteresis")) {
+            report.pow.hysteresis = qRound(loadOb["pow hysteresis"].toDouble(report.pow.hysteresis/10.0)*10);
+        }
+        if(loadOb.contains("bat deadband")) {
+            report.bat.deadband = qRound(loadOb["bat deadband"].toDouble(report.bat.deadband/10.0)*10);
+        }
+        if(loadOb.contains("bat hysteresis")) {
+            report.bat.hysteresis = qRound(loadOb["bat hysteresis"].toDouble(report.bat.hysteresis/10.0)*10);
+        }
+        if(loadOb.contains("report min interval")) {
+            report.minInterval = loadOb["report min interval"].toInt(report.minInterval);
+        }
+        if(loadOb.contains("report max interval")) {
+            report.maxInterval = loadOb["report max interval"].toInt(report.maxInterval);
+        }
         bool gateCntFlag = false;
         if(loadOb.contains("gate cnt")) {
             QString gateCntStr = loadOb["gate cnt"].toString();
@@ -132,6 +175,20 @@ bool ProjectConfig::writeConfig()
         confObject["version"] = "1.1";
         //confObject["gate cnt"] = QString::number(gates.size());
         confObject["audio tmr"] = tmr;
+        confObject["db driver"] = db.driver;
+        confObject["db host"] = db.host;
+        confObject["db port"] = db.port;
+        confObject["db name"] = db.name;
+        confObject["db user"] = db.user;
+        confObject["db password"] = db.password;
+        confObject["db file"] = db.file;
+        confObject["archive months"] = archiveMonths;
+        confObject["pow deadband"] = report.pow.deadband/10.0;
+        confObject["pow hysteresis"] = report.pow.hysteresis/10.0;
+        confObject["bat deadband"] = report.bat.deadband/10.0;
+        confObject["bat hysteresis"] = report.bat.hysteresis/10.0;
+        confObject["report min interval"] = report.minInterval;
+        confObject["report max interval"] = report.maxInterval;
         confObject["gates"] = gateArray;
         confObject["ip1"] = ip1;
         confObject["ip2"] = ip2;
@@ -11,12 +11,40 @@ struct GateState{
     static const int maxPointQuantity;
 };
 
+// параметры подключения к базе архива
+struct DBSettings {
+    QString driver = "QPSQL";       // QPSQL - прямое подключение, QODBC - через ODBC, QSQLITE - файл без сервера
+    QString host = "localhost";
+    int port = 5432;
+    QString name = "voip";
+    QString user = "postgres";
+    QString password = "interrupt";
+    QString file = "voip.sqlite";   // база QSQLITE, относительный путь - от каталога программы
+};
+
+// зона нечувствительности аналогового значения точки, в 0.1 В
+struct AnalogBand {
+    int deadband = 3;       // отклонение от записанного значения, с которого пишется новая строка
+    int hysteresis = 1;     // добавка к зоне при смене направления изменения, гасит дребезг между соседними значениями
+};
+
+// отбор строк таблицы points: смена состояний пишется всегда, аналоговые значения - через зону нечувствительности
+struct ReportSettings {
+    AnalogBand pow;
+    AnalogBand bat;
+    int minInterval = 10;   // с, изменения только аналоговых значений пишутся не чаще
+    int maxInterval = 300;  // с, строка точки пишется не реже, даже без изменений
+};
+
 class ProjectConfig
 {
     QString fName;
 public:
     static const int maxGateQuantity;
     QString ip1,ip2,ip3,ip4,tmr;
+    DBSettings db;
+    int archiveMonths = 12;         // срок хранения архива в месяцах, 0 - без ограничения
+    ReportSettings report;
     std::vector<GateState> gates;
     explicit ProjectConfig(const QString &fileName);
     bool readConfig();
@@ -0,0 +1,29 @@
+#include "recorddiff.h"
+#include <cstring>
+#include <algorithm>
+
+QBitArray RecordDiff::changed(const QByteArray &data, const QByteArray &last, int offset, int recordSize, int count, const QByteArray &mask)
+{
+    QBitArray bits(std::max(count,0));
+    if(recordSize<=0 || mask.size()<recordSize) return bits;
+    int full = (std::min(data.size(),last.size())-offset)/recordSize;
+    int size = std::min(count,full)*recordSize;
+    if(size<=0) return bits;
+    const char *a = data.constData()+offset;
+    const char *b = last.constData()+offset;
+    int pos = 0;
+    for(;pos+8<=size;pos+=8) {
+        quint64 x, y;
+        std::memcpy(&x,a+pos,8);
+        std::memcpy(&y,b+pos,8);
+        // кадр обычно не меняется целиком - большинство слов совпадает
+        if(x==y) continue;
+        for(int i=pos;i<pos+8;i++) {
+            if(a[i]!=b[i] && mask.at(i%recordSize)) bits.setBit(i/recordSize);
+        }
+    }
+    for(;pos<size;pos++) {
+        if(a[pos]!=b[pos] && mask.at(pos%recordSize)) bits.setBit(pos/recordSize);
+    }
+    return bits;
+}
@@ -0,0 +1,20 @@
+#ifndef RECORDDIFF_H
+#define RECORDDIFF_H
+
+// сравнение двух кадров телеметрии по сырым записям фиксированной длины
+
+#include <QByteArray>
+#include <QBitArray>
+
+class RecordDiff
+{
+private:
+    RecordDiff();
+public:
+    // кадры сравниваются словами по 8 байт, байты записей разбираются только в отличающихся словах
+    // offset - начало первой записи, mask - значимые байты записи (ненулевые), результат - карта изменённых записей
+    // запись, которой нет целиком в одном из кадров, изменённой не считается
+    static QBitArray changed(const QByteArray &data, const QByteArray &last, int offset, int recordSize, int count, const QByteArray &mask);
+};
+
+#endif // RECORDDIFF_H
@@ -0,0 +1,119 @@
+#include "recordmanager.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+
+RecordManager::RecordManager(TranscodePool *pool, QObject *parent) : QObject(parent), pool(pool)
+{
+    qRegisterMetaType<RecordSegment>("RecordSegment");
+    writer = new RecordWriter();
+    writer->moveToThread(&recordThread);
+    connect(&recordThread, &QThread::finished, writer, &QObject::deleteLater);
+    connect(this, &RecordManager::init, writer, &RecordWriter::work);
+    connect(writer, &RecordWriter::segmentFinished, this, &RecordManager::segmentFinished);
+    connect(writer, &RecordWriter::segmentFinished, this, &RecordManager::convertSegment);
+    connect(pool, &TranscodePool::jobFinished, this, &RecordManager::jobFinished);
+    recordThread.start();
+    emit init();
+}
+
+RecordManager::~RecordManager()
+{
+    writer->finish();
+    recordThread.quit();
+    recordThread.wait();
+    // фрагменты, закрытые при остановке, ставятся в очередь конвертации
+    QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+}
+
+void RecordManager::startStream(const QString &gate, quint8 group, quint8 point)
+{
+    writer->startStream(RecordKey{gate,group,point});
+}
+
+void RecordManager::appendAudio(const QString &gate, quint8 group, quint8 point, const QByteArray &data)
+{
+    writer->appendAudio(RecordKey{gate,group,point},data);
+}
+
+void RecordManager::stopStream(const QString &gate, quint8 group, quint8 point)
+{
+    writer->stopStream(RecordKey{gate,group,point});
+}
+
+void RecordManager::stopAll()
+{
+    writer->stopAll();
+}
+
+void RecordManager::setGate(const QString &value)
+{
+    QMutexLocker locker(&gateMutex);
+    gate = value;
+}
+
+QString RecordManager::currentGate() const
+{
+    QMutexLocker locker(&gateMutex);
+    return gate;
+}
+
+void RecordManager::startRecord(uint8_t gr, uint8_t point)
+{
+    startStream(currentGate(),gr,point);
+}
+
+void RecordManager::recordAudio(uint8_t gr, uint8_t point, const QByteArray &data)
+{
+    appendAudio(currentGate(),gr,point,data);
+}
+
+void RecordManager::stopRecord(uint8_t gr, uint8_t point)
+{
+    stopStream(currentGate(),gr,point);
+}
+
+void RecordManager::convertSegment(const RecordSegment &segment)
+{
+    // меняется только расширение: "pcm" может встретиться и в каталоге программы
+    QFileInfo source(segment.fileName);
+    QString outName = source.path() + "/" + source.completeBaseName() + ".mp3";
+    while(QFile::exists(outName)) {
+        outName.remove(".mp3");
+        outName+="_again.mp3";
+    }
+    TranscodeJob job;
+    job.source = segment.fileName;
+    job.target = outName;
+    job.inputArguments << "-loglevel" << "fatal" << "-f" << "s16le" << "-ar" << "8k" << "-ac" << "1";
+    job.arguments << "-filter:a" << "volume="+QString::number(WaveformPyramid::recordGain) << "-codec:a" << "libmp3lame" << "-qscale:a" << "5";
+    job.tag = "record";
+    job.meta["gate"] = segment.key.gate;
+    job.meta["group"] = segment.key.group;
+    job.meta["point"] = segment.key.point;
+    job.meta["start"] = QString::number(segment.startTime);
+    job.meta["duration"] = QString::number(segment.duration);
+    pool->enqueue(job);
+}
+
+void RecordManager::jobFinished(const TranscodeJob &job, bool ok)
+{
+    if(!ok || job.tag!="record") return;
+    RecordSegment record;
+    record.key.gate = job.meta["gate"].toString();
+    record.key.group = static_cast<quint8>(job.meta["group"].toInt());
+    record.key.point = static_cast<quint8>(job.meta["point"].toInt());
+    record.startTime = job.meta["start"].toString().toLongLong();
+    record.duration = job.meta["duration"].toString().toLongLong();
+    record.fileName = job.target;
+    record.codec = "mp3";
+    record.bytes = QFileInfo(job.target).size();
+    // огибающая следует за переименованным файлом записи
+    QString waveSource = WaveformPyramid::sidecarName(job.source);
+    QString waveTarget = WaveformPyramid::sidecarName(job.target);
+    if(waveSource!=waveTarget && QFile::exists(waveSource)) {
+        QFile::remove(waveTarget);
+        QFile::rename(waveSource,waveTarget);
+    }
+    emit recordReady(record);
+}
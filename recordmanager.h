@@ -0,0 +1,44 @@
+#ifndef RECORDMANAGER_H
+#define RECORDMANAGER_H
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include "recordwriter.h"
+#include "transcodepool.h"
+
+class RecordManager : public QObject
+{
+    Q_OBJECT
+    RecordWriter *writer;
+    QThread recordThread;
+    TranscodePool *pool;
+    mutable QMutex gateMutex;
+    QString gate;
+    QString currentGate() const;
+public:
+    explicit RecordManager(TranscodePool *pool, QObject *parent = nullptr);
+    ~RecordManager();
+    void startStream(const QString &gate, quint8 group, quint8 point);
+    void appendAudio(const QString &gate, quint8 group, quint8 point, const QByteArray &data);
+    void stopStream(const QString &gate, quint8 group, quint8 point);
+    void stopAll();
+    // вызываются напрямую из потока обмена: данные сразу уходят в очередь потока записи
+    void setGate(const QString &value);
+    void startRecord(uint8_t gr, uint8_t point);
+    void recordAudio(uint8_t gr, uint8_t point, const QByteArray &data);
+    void stopRecord(uint8_t gr, uint8_t point);
+    int activeStreams() const {return writer->activeStreams();}
+    quint64 getDroppedBytes() const {return writer->getDroppedBytes();}
+
+signals:
+    void init();
+    void segmentFinished(const RecordSegment &segment);
+    void recordReady(const RecordSegment &record);     // запись сконвертирована и готова для каталога
+
+private slots:
+    void convertSegment(const RecordSegment &segment);
+    void jobFinished(const TranscodeJob &job, bool ok);
+};
+
+#endif // RECORDMANAGER_H
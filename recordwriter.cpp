@@ -0,0 +1,179 @@
+#include "recordwriter.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+
+RecordWriter::RecordWriter(QObject *parent) : QObject(parent)
+{
+
+}
+
+void RecordWriter::finish()
+{
+    QMutexLocker locker(&mutex);
+    finishFlag = true;
+    wake.wakeOne();
+}
+
+RecordWriter::Stream &RecordWriter::stream(const RecordKey &key)
+{
+    Stream &s = streams[key];
+    // точка заговорила снова до того, как поток записи закрыл прежний фрагмент:
+    // прежний уходит на закрытие, новый начинается своим файлом и своим временем
+    if(s.stop) {
+        Batch b;
+        b.key = key;
+        b.data.swap(s.pending);
+        b.startTime = s.startTime;
+        b.stop = true;
+        closing.push_back(std::move(b));
+        s = Stream();
+    }
+    if(s.startTime==0) s.startTime = QDateTime::currentMSecsSinceEpoch();
+    return s;
+}
+
+void RecordWriter::startStream(const RecordKey &key)
+{
+    QMutexLocker locker(&mutex);
+    stream(key);
+}
+
+void RecordWriter::appendAudio(const RecordKey &key, const QByteArray &data)
+{
+    QMutexLocker locker(&mutex);
+    Stream &s = stream(key);
+    s.pending.append(data);
+    // поток записи не успевает - отбрасываем самые старые отсчёты
+    if(s.pending.size()>maxPendingBytes) {
+        int extra = s.pending.size()-maxPendingBytes;
+        extra += extra & 1;
+        s.pending.remove(0,extra);
+        droppedBytes += static_cast<quint64>(extra);
+    }
+    if(s.pending.size()>=flushBytes) wake.wakeOne();
+}
+
+void RecordWriter::stopStream(const RecordKey &key)
+{
+    QMutexLocker locker(&mutex);
+    auto it = streams.find(key);
+    if(it!=streams.end()) {
+        it->second.stop = true;
+        wake.wakeOne();
+    }
+}
+
+void RecordWriter::stopAll()
+{
+    QMutexLocker locker(&mutex);
+    for(auto &s:streams) s.second.stop = true;
+    wake.wakeOne();
+}
+
+int RecordWriter::activeStreams() const
+{
+    QMutexLocker locker(&mutex);
+    return static_cast<int>(streams.size());
+}
+
+quint64 RecordWriter::getDroppedBytes() const
+{
+    QMutexLocker locker(&mutex);
+    return droppedBytes;
+}
+
+quint64 RecordWriter::getWrittenBytes() const
+{
+    QMutexLocker locker(&mutex);
+    return writtenBytes;
+}
+
+QString RecordWriter::createFileName(const RecordKey &key, qint64 startTime)
+{
+    QString fName = QCoreApplication::applicationDirPath() + "/audio_records/gr"+QString::number(key.group);
+    fName+="_point"+QString::number(key.point);
+    fName+= QDateTime::fromMSecsSinceEpoch(startTime).toString("_dd_MM_yyyy_hh_mm_ss") + ".pcm";
+    while(QFile::exists(fName) || QFile::exists(WaveformPyramid::sidecarName(fName))) {fName.remove(".pcm");fName+="_again.pcm";}
+    return fName;
+}
+
+void RecordWriter::closeFile(std::map<RecordKey,OpenFile>::iterator it)
+{
+    OpenFile &f = it->second;
+    f.file->close();
+    f.wave.finish();
+    f.wave.save(WaveformPyramid::sidecarName(f.segment.fileName));
+    // 8000 отсчётов по 2 байта в секунду
+    f.segment.duration = f.segment.bytes/16;
+    emit segmentFinished(f.segment);
+    files.erase(it);
+}
+
+void RecordWriter::writeBatch(std::vector<Batch> &batch)
+{
+    quint64 written = 0;
+    for(Batch &b:batch) {
+        auto it = files.find(b.key);
+        if(!b.data.isEmpty()) {
+            if(it==files.end()) {
+                OpenFile f;
+                f.segment.key = b.key;
+                f.segment.fileName = createFileName(b.key,b.startTime);
+                f.segment.startTime = b.startTime;
+                f.file = std::make_unique<QFile>(f.segment.fileName);
+                // огибающая в масштабе mp3, который декодируется для подробного просмотра
+                f.wave.setGain(WaveformPyramid::recordGain);
+                if(f.file->open(QIODevice::WriteOnly)) it = files.emplace(b.key,std::move(f)).first;
+            }
+            if(it!=files.end()) {
+                qint64 cnt = it->second.file->write(b.data);
+                if(cnt>0) {
+                    it->second.wave.append(cnt==b.data.size() ? b.data : b.data.left(static_cast<int>(cnt)));
+                    it->second.segment.bytes += cnt;
+                    written += static_cast<quint64>(cnt);
+                }
+            }
+        }
+        if(b.stop && it!=files.end()) closeFile(it);
+    }
+    if(written) {
+        QMutexLocker locker(&mutex);
+        writtenBytes += written;
+    }
+}
+
+void RecordWriter::work()
+{
+    QDir().mkpath(QCoreApplication::applicationDirPath() + "/audio_records");
+    for(;;) {
+        std::vector<Batch> batch;
+        mutex.lock();
+        if(!finishFlag) wake.wait(&mutex,flushPeriodMs);
+        // закрываемые фрагменты идут раньше данных новых потоков той же точки
+        batch.swap(closing);
+        bool finishFlagState = finishFlag;
+        qint64 now = QDateTime::currentMSecsSinceEpoch();
+        // забираем накопленные данные всех потоков одним проходом
+        for(auto it=streams.begin();it!=streams.end();) {
+            Stream &s = it->second;
+            bool rotate = now-s.startTime>=segmentDuration;
+            if(!s.pending.isEmpty() || s.stop || rotate || finishFlagState) {
+                Batch b;
+                b.key = it->first;
+                b.data.swap(s.pending);
+                b.startTime = s.startTime;
+                b.stop = s.stop || rotate || finishFlagState;
+                batch.push_back(std::move(b));
+            }
+            if(s.stop || finishFlagState) it = streams.erase(it);
+            else {
+                if(rotate) s.startTime = now;
+                ++it;
+            }
+        }
+        mutex.unlock();
+        writeBatch(batch);
+        if(finishFlagState) break;
+    }
+}
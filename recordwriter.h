@@ -0,0 +1,98 @@
+#ifndef RECORDWRITER_H
+#define RECORDWRITER_H
+
+#include <QObject>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QByteArray>
+#include <QString>
+#include <QFile>
+#include <map>
+#include <vector>
+#include <memory>
+#include <tuple>
+#include "waveformpyramid.h"
+
+// ключ потока записи: шлюз, группа, точка
+struct RecordKey {
+    QString gate;
+    quint8 group = 0;
+    quint8 point = 0;
+    bool operator<(const RecordKey &other) const {
+        return std::tie(gate,group,point) < std::tie(other.gate,other.group,other.point);
+    }
+};
+
+// завершённый фрагмент записи
+struct RecordSegment {
+    RecordKey key;
+    QString fileName;
+    qint64 startTime = 0;   // мс с начала эпохи
+    qint64 duration = 0;    // мс
+    qint64 bytes = 0;
+    QString codec = "pcm_s16le";
+};
+Q_DECLARE_METATYPE(RecordSegment)
+
+// запись нескольких одновременных аудиопотоков в отдельные файлы
+// данные копятся в ограниченных буферах и пишутся пачками из одного потока
+class RecordWriter : public QObject
+{
+    Q_OBJECT
+
+    struct Stream {
+        QByteArray pending;
+        qint64 startTime = 0;
+        bool stop = false;
+    };
+
+    struct OpenFile {
+        std::unique_ptr<QFile> file;
+        RecordSegment segment;
+        WaveformPyramid wave;   // огибающая считается по ходу записи
+    };
+
+    struct Batch {
+        RecordKey key;
+        QByteArray data;
+        qint64 startTime = 0;
+        bool stop = false;
+    };
+
+    mutable QMutex mutex;
+    QWaitCondition wake;
+    bool finishFlag = false;
+    std::map<RecordKey,Stream> streams;     // защищено mutex
+    std::vector<Batch> closing;             // остановленные потоки, ещё не забранные потоком записи; защищено mutex
+    std::map<RecordKey,OpenFile> files;     // только поток записи
+    quint64 droppedBytes = 0;
+    quint64 writtenBytes = 0;
+
+    static const int maxPendingBytes = 64*1024;     // ~4 с звука 8 кГц 16 бит на поток
+    static const int flushBytes = 16000;            // ~1 с звука
+    static const int flushPeriodMs = 500;
+    static const qint64 segmentDuration = 300000;   // 5 минут на файл
+
+    Stream &stream(const RecordKey &key);
+    void writeBatch(std::vector<Batch> &batch);
+    void closeFile(std::map<RecordKey,OpenFile>::iterator it);
+    static QString createFileName(const RecordKey &key, qint64 startTime);
+
+public:
+    explicit RecordWriter(QObject *parent = nullptr);
+    void finish();
+    void startStream(const RecordKey &key);
+    void appendAudio(const RecordKey &key, const QByteArray &data);
+    void stopStream(const RecordKey &key);
+    void stopAll();
+    int activeStreams() const;
+    quint64 getDroppedBytes() const;
+    quint64 getWrittenBytes() const;
+
+signals:
+    void segmentFinished(const RecordSegment &segment);
+public slots:
+    void work();
+};
+
+#endif // RECORDWRITER_H
@@ -0,0 +1,48 @@
+#include "reportfilter.h"
+#include <cstdlib>
+
+bool ReportFilter::moved(const AnalogBand &band, int value, int reported, int dir)
+{
+    int delta = value-reported;
+    if(delta==0) return false;
+    // возврат назад требует большего отклонения, чем продолжение изменения
+    int threshold = band.deadband;
+    if(dir && (delta>0 ? 1 : -1)!=dir) threshold += band.hysteresis;
+    return std::abs(delta)>=threshold;
+}
+
+int ReportFilter::direction(int value, int reported, int dir)
+{
+    if(value==reported) return dir;
+    return value>reported ? 1 : -1;
+}
+
+bool ReportFilter::accept(quint8 gate, quint8 point, const Sample &sample, qint64 time)
+{
+    quint16 key = static_cast<quint16>(gate<<8 | point);
+    auto it = points.find(key);
+    if(it==points.end()) {
+        Reported r;
+        r.sample = sample;
+        r.time = time;
+        points.emplace(key,r);
+        return true;
+    }
+    Reported &r = it->second;
+    qint64 age = time-r.time;
+    bool write = sample.states!=r.sample.states;
+    if(!write && age>=settings.minInterval*1000LL) {
+        write = moved(settings.pow,sample.pow,r.sample.pow,r.powDir) || moved(settings.bat,sample.bat,r.sample.bat,r.batDir);
+    }
+    // строка не реже maxInterval: архив за любой интервал содержит значения точки
+    if(!write && age>=settings.maxInterval*1000LL) write = true;
+    if(!write) {
+        suppressed++;
+        return false;
+    }
+    r.powDir = direction(sample.pow,r.sample.pow,r.powDir);
+    r.batDir = direction(sample.bat,r.sample.bat,r.batDir);
+    r.sample = sample;
+    r.time = time;
+    return true;
+}
@@ -0,0 +1,42 @@
+#ifndef REPORTFILTER_H
+#define REPORTFILTER_H
+
+#include <QtGlobal>
+#include <array>
+#include <map>
+#include "projectconfig.h"
+
+// отбор строк таблицы points по последним записанным значениям каждой точки
+// смена любого состояния пишется сразу, дребезг аналоговых значений в пределах зоны отбрасывается
+class ReportFilter
+{
+public:
+    struct Sample {
+        std::array<qint16,5> states{};  // коды di1, di2, do1, do2, speaker
+        int pow = 0;                    // 0.1 В
+        int bat = 0;
+    };
+
+    void setSettings(const ReportSettings &value) {settings = value;}
+    // true - строку нужно записать, time - время кадра в мс
+    bool accept(quint8 gate, quint8 point, const Sample &sample, qint64 time);
+    void clear() {points.clear();}
+    quint64 getSuppressed() const {return suppressed;}
+
+private:
+    struct Reported {
+        Sample sample;
+        int powDir = 0;                 // направление последнего записанного изменения
+        int batDir = 0;
+        qint64 time = 0;
+    };
+
+    ReportSettings settings;
+    std::map<quint16,Reported> points;  // ключ - группа и точка
+    quint64 suppressed = 0;
+
+    static bool moved(const AnalogBand &band, int value, int reported, int dir);
+    static int direction(int value, int reported, int dir);
+};
+
+#endif // REPORTFILTER_H
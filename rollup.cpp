@@ -0,0 +1,112 @@
+#include "rollup.h"
+#include <QDateTime>
+#include <algorithm>
+
+Rollup::Rollup(int channels, bool withPoint) : channels(std::min(channels,maxChannels)), withPoint(withPoint)
+{
+
+}
+
+qint64 Rollup::periodSeconds(Period period)
+{
+    switch(period) {
+        case MINUTE: return 60;
+        case HOUR: return 3600;
+        default: return 86400;
+    }
+}
+
+int Rollup::coarsest(qint64 resolution)
+{
+    for(int p=DAY;p>=MINUTE;p--) {
+        if(periodSeconds(static_cast<Period>(p))<=resolution) return p;
+    }
+    return -1;
+}
+
+qint64 Rollup::bucketStart(Period period, qint64 time)
+{
+    if(period==MINUTE) return time-time%60000;
+    // часы и сутки по местному времени, как их видит оператор
+    QDateTime dt = QDateTime::fromMSecsSinceEpoch(time);
+    if(period==HOUR) return QDateTime(dt.date(),QTime(dt.time().hour(),0)).toMSecsSinceEpoch();
+    return QDateTime(dt.date(),QTime(0,0)).toMSecsSinceEpoch();
+}
+
+Rollup::Cell &Rollup::cell(quint16 key, Period period, qint64 time)
+{
+    Cell &c = cells[key][period];
+    if(time>=c.bucket && time<c.end) return c;
+    // значение из следующего периода: прошлая ячейка закрывается
+    if(c.values || c.alarms) closed.push_back({key,period,c});
+    Cell next;
+    next.bucket = bucketStart(period,time);
+    // конец - начало следующего периода: сутки с переводом часов короче или длиннее 24 ч
+    qint64 length = periodSeconds(period)*1000;
+    next.end = period==MINUTE ? next.bucket+length : bucketStart(period,next.bucket+length*3/2);
+    if(next.end<=next.bucket) next.end = next.bucket+length;
+    c = next;
+    return c;
+}
+
+void Rollup::add(quint8 gate, quint8 point, const std::array<int,maxChannels> &values, bool average, qint64 time)
+{
+    quint16 key = static_cast<quint16>(gate<<8 | point);
+    for(int p=0;p<PERIOD_CNT;p++) {
+        Cell &c = cell(key,static_cast<Period>(p),time);
+        for(int i=0;i<channels;i++) {
+            Channel &ch = c.ch[i];
+            if(!c.values) ch.min = ch.max = values[i];
+            ch.min = std::min(ch.min,values[i]);
+            ch.max = std::max(ch.max,values[i]);
+            ch.last = values[i];
+            if(average) ch.sum += values[i];
+        }
+        c.values++;
+        if(average) c.samples++;
+    }
+}
+
+void Rollup::alarm(quint8 gate, quint8 point, qint64 time)
+{
+    quint16 key = static_cast<quint16>(gate<<8 | point);
+    for(int p=0;p<PERIOD_CNT;p++) cell(key,static_cast<Period>(p),time).alarms++;
+}
+
+void Rollup::appendRow(QVariantList &rows, const QString &ip, quint16 key, Period period, const Cell &c) const
+{
+    rows << ip << static_cast<int>(period) << QDateTime::fromMSecsSinceEpoch(c.bucket) << (key>>8);
+    if(withPoint) rows << (key & 0xFF);
+    rows << c.samples;
+    for(int i=0;i<channels;i++) {
+        const Channel &ch = c.ch[i];
+        // только тревоги без значений - значения пустые
+        if(!c.values) {
+            rows << QVariant() << QVariant() << QVariant() << QVariant();
+            continue;
+        }
+        double avg = c.samples ? static_cast<double>(ch.sum)/c.samples : ch.last;
+        rows << ch.min << ch.max << avg << ch.last;
+    }
+    rows << c.alarms;
+}
+
+void Rollup::flush(const QString &ip, QVariantList &rows, bool all)
+{
+    for(const Closed &c:closed) appendRow(rows,ip,c.key,c.period,c.cell);
+    closed.clear();
+    if(!all) return;
+    for(auto &k:cells) {
+        for(int p=0;p<PERIOD_CNT;p++) {
+            Cell &c = k.second[p];
+            if(!c.values && !c.alarms) continue;
+            appendRow(rows,ip,k.first,static_cast<Period>(p),c);
+            // ячейка остаётся открытой, следующая часть досчитывается с нуля
+            qint64 bucket = c.bucket;
+            qint64 end = c.end;
+            c = Cell();
+            c.bucket = bucket;
+            c.end = end;
+        }
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef ROLLUP_H
+#define ROLLUP_H
+
+#include <QString>
+#include <QVariantList>
+#include <array>
+#include <map>
+#include <vector>
+
+// минутные, часовые и суточные агрегаты значений точек или групп, копятся в памяти
+// закрытые ячейки выгружаются в строки при каждой записи, открытые - периодически частями,
+// части одной ячейки складываются в базе при вставке
+class Rollup
+{
+public:
+    enum Period {MINUTE,HOUR,DAY,PERIOD_CNT};
+    static const int maxChannels = 2;
+
+    // channels - число значений (питание и аккумулятор у точки, число точек у группы)
+    // withPoint - в строке есть номер точки
+    Rollup(int channels, bool withPoint);
+    // average - значение из равномерной выборки по таймеру, только такие входят в среднее
+    void add(quint8 gate, quint8 point, const std::array<int,maxChannels> &values, bool average, qint64 time);
+    void alarm(quint8 gate, quint8 point, qint64 time);
+    // all - выгрузить и накопленное в открытых ячейках
+    void flush(const QString &ip, QVariantList &rows, bool all);
+
+    static qint64 periodSeconds(Period period);
+    // самый крупный период не длиннее resolution секунд, -1 - нужна исходная история
+    static int coarsest(qint64 resolution);
+
+private:
+    struct Channel {
+        int min = 0;
+        int max = 0;
+        qint64 sum = 0;
+        int last = 0;
+    };
+    struct Cell {
+        qint64 bucket = -1;     // начало периода, мс
+        qint64 end = -1;
+        int values = 0;         // всего значений
+        int samples = 0;        // значений, вошедших в среднее
+        int alarms = 0;         // переходов тревог
+        std::array<Channel,maxChannels> ch;
+    };
+    struct Closed {
+        quint16 key;
+        Period period;
+        Cell cell;
+    };
+
+    int channels;
+    bool withPoint;
+    std::map<quint16,std::array<Cell,PERIOD_CNT>> cells;   // ключ - группа и точка
+    std::vector<Closed> closed;
+
+    static qint64 bucketStart(Period period, qint64 time);
+    Cell &cell(quint16 key, Period period, qint64 time);
+    void appendRow(QVariantList &rows, const QString &ip, quint16 key, Period period, const Cell &c) const;
+};
+
+#endif // ROLLUP_H
@@ -0,0 +1,37 @@
+#include "scopebuffer.h"
+
+ScopeBuffer::ScopeBuffer(QCustomPlot *plot, int size) : plot(plot), size(size)
+{
+    QVector<QCPGraphData> points(size);
+    for(int i=0;i<size;i++) points[i] = QCPGraphData(i,0);
+    plot->xAxis->setTickLabels(false);
+    plot->yAxis->setTickLabels(false);
+    plot->addGraph();
+    data = plot->graph(0)->data();
+    data->set(points,true);
+    plot->xAxis->setRange(0, size);
+    plot->yAxis->setRange(-1, 1);
+    plot->replot();
+}
+
+void ScopeBuffer::append(const QVector<double> &samples)
+{
+    // из длинной пачки видны только последние size отсчётов
+    int from = qMax(0,samples.size()-size);
+    QCPGraphDataContainer::iterator it = data->begin();
+    for(int i=from;i<samples.size();i++) {
+        (it+pos)->value = samples[i];
+        if(++pos==size) pos = 0;
+    }
+    // разрыв линии перед самым старым отсчётом отделяет новые данные от прошлого прохода
+    (it+pos)->value = qQNaN();
+    changed = true;
+}
+
+bool ScopeBuffer::replot()
+{
+    if(!changed) return false;
+    changed = false;
+    plot->replot(QCustomPlot::rpQueuedReplot);
+    return true;
+}
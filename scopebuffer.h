@@ -0,0 +1,23 @@
+#ifndef SCOPEBUFFER_H
+#define SCOPEBUFFER_H
+
+#include "qcustomplot.h"
+#include <QVector>
+
+// осциллограмма звука: отсчёты пишутся по кругу поверх данных графика без выделения памяти,
+// перерисовка - по таймеру окна и только при наличии новых отсчётов
+class ScopeBuffer
+{
+    QCustomPlot *plot;
+    QSharedPointer<QCPGraphDataContainer> data;
+    int size;
+    int pos = 0;            // позиция записи следующего отсчёта
+    bool changed = false;
+
+public:
+    explicit ScopeBuffer(QCustomPlot *plot, int size = 1000);
+    void append(const QVector<double> &samples);
+    bool replot();
+};
+
+#endif // SCOPEBUFFER_H
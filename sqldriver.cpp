@@ -1,269 +1,137 @@
 #include "sqldriver.h"
-#include <QThread>
+#include "sqlschema.h"
 #include "QSqlQuery"
 #include <QSqlRecord>
 #include <QDebug>
 #include <QDateTime>
+#include <QElapsedTimer>
+#include <QDir>
+#include <QCoreApplication>
 #include <QMessageBox>
 #include "pointdata.h"
 #include "groupdata.h"
+#include "recorddiff.h"
+#include <algorithm>
+
+// байты записей, которые попадают в базу: версия, порог звука и фильтры входов не пишутся
+const QByteArray SQLDriver::pointMask = QByteArray::fromHex("ffffffff00ffff0000");
+const QByteArray SQLDriver::groupMask = QByteArray::fromHex("ffff00ffff");
+
+bool SQLDriver::openDatabase(QSqlDatabase &db, const DBSettings &settings, const QString &connectionName)
+{
+    QString name = settings.driver;
+    // QPSQL работает с сервером напрямую через libpq, без него остаётся ODBC
+    if(name=="QPSQL" && !QSqlDatabase::isDriverAvailable(name)) name = "QODBC";
+    if(!db.isValid() || db.driverName()!=name) {
+        if(db.isOpen()) db.close();
+        db = QSqlDatabase();
+        QSqlDatabase::removeDatabase(connectionName);
+        db = QSqlDatabase::addDatabase(name,connectionName);
+    }
+    if(name=="QSQLITE") {
+        QDir dir(QCoreApplication::applicationDirPath());
+        db.setDatabaseName(dir.absoluteFilePath(settings.file));
+        if(!db.open()) return false;
+        // WAL: чтение архива не блокирует запись, фиксация без fsync на каждую транзакцию
+        QSqlQuery query(db);
+        query.exec("PRAGMA journal_mode=WAL;");
+        query.exec("PRAGMA synchronous=NORMAL;");
+        query.exec("PRAGMA busy_timeout=5000;");
+        return true;
+    }
+    //db.setDatabaseName("Driver={MySQL ODBC 8.0 Unicode Driver};Database=voip;");
+    if(name=="QODBC") db.setDatabaseName("Driver={PostgreSQL Unicode};Database="+settings.name+";");
+    else db.setDatabaseName(settings.name);
+    db.setHostName(settings.host);
+    db.setUserName(settings.user);
+    db.setPassword(settings.password);
+    db.setPort(settings.port);
+    return db.open();
+}
 
 void SQLDriver::initDataBase()
 {
     qRegisterMetaType<Qt::Orientation>("Qt::Orientation");
-    //db.setDatabaseName("Driver={MySQL ODBC 8.0 Unicode Driver};Database=voip;");
-    db.setDatabaseName("Driver={PostgreSQL Unicode};Database=voip;");
-    db.setHostName("localhost");
-    db.setUserName("postgres");
-    db.setPassword("interrupt");
-    db.setPort(5432);
-    if (!db.open())
+    statements.clear();
+    gateways.clear();
+    maintenanceDate = QDate();
+    lastConnectAttempt = QDateTime::currentMSecsSinceEpoch();
+    mutex.lock();
+    DBSettings current = settings;
+    mutex.unlock();
+    if (!openDatabase(db,current,QSqlDatabase::defaultConnection))
     {
-        emit error("ОШИБКА ПОДКЛЮЧЕНИЯ К БАЗЕ ДАННЫХ!");
+        // повторные попытки идут молча, данные тем временем пишутся в локальный журнал
+        if(!connectionLost) emit error("ОШИБКА ПОДКЛЮЧЕНИЯ К БАЗЕ ДАННЫХ!");
+        connectionLost = true;
     }else {
-        QSqlQuery query;
-        query.exec("CREATE TABLE IF NOT EXISTS points ("
-                   "id SERIAL PRIMARY KEY NOT NULL,"
-                   "num smallint NOT NULL,"
-                   "gate smallint NOT NULL,"
-                   "di1 TEXT NOT NULL, "
-                   "di2 TEXT NOT NULL, "
-                   "do1 TEXT NOT NULL, "
-                   "do2 TEXT NOT NULL, "
-                   "speaker TEXT NOT NULL, "
-                   "pow REAL NOT NULL,"
-                   "bat REAL NOT NULL,"
-                   "ip TEXT NOT NULL,"
-                   "tmr TIMESTAMP DEFAULT CURRENT_TIMESTAMP NOT NULL"
-                   ");");
-        query.exec("CREATE TABLE IF NOT EXISTS gates ("
-                   "id SERIAL PRIMARY KEY NOT NULL,"
-                   "num INTEGER NOT NULL,"
-                   "ip TEXT NOT NULL,"
-                   "cnt smallint NOT NULL,"
-                   "di1 TEXT NOT NULL, "
-                   "di2 TEXT NOT NULL, "
-                   "di3 TEXT NOT NULL, "
-                   "do1 TEXT NOT NULL, "
-                   "do2 TEXT NOT NULL, "
-                   "tmr TIMESTAMP DEFAULT CURRENT_TIMESTAMP NOT NULL"
-                   ");");
-        query.exec("CREATE TABLE IF NOT EXISTS point_alarms ("
-                   "id SERIAL PRIMARY KEY NOT NULL,"
-                   "alarm TEXT,"
-                   "type TEXT,"
-                   "point smallint NOT NULL,"
-                   "gate smallint NOT NULL,"
-                   "ip TEXT NOT NULL,"
-                   "tmr TIMESTAMP DEFAULT CURRENT_TIMESTAMP NOT NULL"
-                   ");");
-        query.exec("CREATE TABLE IF NOT EXISTS gate_alarms ("
-                   "id SERIAL PRIMARY KEY NOT NULL,"
-                   "alarm TEXT,"
-                   "type TEXT,"
-                   "gate smallint NOT NULL,"
-                   "ip TEXT NOT NULL,"
-                   "tmr TIMESTAMP DEFAULT CURRENT_TIMESTAMP NOT NULL"
-                   ");");
-        query.exec("CREATE TABLE IF NOT EXISTS journal ("
-                   "id SERIAL PRIMARY KEY NOT NULL,"
-                   "message VARCHAR(64),"
-                   "type TEXT,"
-                   "tmr TIMESTAMP DEFAULT CURRENT_TIMESTAMP NOT NULL"
-                   ");");
-    }
-    journalModel = new ColoredSqlQueryModel(nullptr);
-    pointModel = new ColoredSqlQueryModel(nullptr);
-    groupModel = new ColoredSqlQueryModel(nullptr);
-    groupAlarmModel = new ColoredSqlQueryModel(nullptr);
-    pointAlarmModel = new ColoredSqlQueryModel(nullptr);
+        connectionLost = false;
+        QString schemaError;
+        if(!SQLSchema::update(db,schemaError)) emit error("ОШИБКА ОБНОВЛЕНИЯ БАЗЫ ДАННЫХ: "+schemaError);
+    }
 }
 
-void SQLDriver::insertDatatoDataBase()
+void SQLDriver::addPointRow(const PointData &p, bool noData, bool timer)
 {
-    double acc, pow;
-    QString di1,di2,do1,do2,speaker;
-    QString gdi1,gdi2,gdi3,gdo1,gdo2;
-
+    ReportFilter::Sample sample;
+    if(noData) sample.states.fill(SQLSchema::stateCode("нет данных"));
+    else {
+        sample.states = {SQLSchema::stateCode(p.getInput1String()),SQLSchema::stateCode(p.getInput2String()),
+                         SQLSchema::stateCode(p.getOutput1String()),SQLSchema::stateCode(p.getOutput2String()),
+                         SQLSchema::stateCode(p.getSpeakerString())};
+        sample.pow = qRound(p.getPowerVoltage()*10);
+        sample.bat = qRound(p.getAccumulatorVoltage()*10);
+        // агрегаты считаются по всем значениям до отбора строк, среднее - по отсчётам таймера
+        pointRollup.add(p.getGroupNum(),p.getPointNum(),{sample.pow,sample.bat},timer,rowTime.toMSecsSinceEpoch());
+    }
+    if(!reportFilter.accept(p.getGroupNum(),p.getPointNum(),sample,rowTime.toMSecsSinceEpoch())) return;
+    pointRows << ip << p.getGroupNum() << p.getPointNum();
+    for(qint16 state:sample.states) pointRows << state;
+    pointRows << sample.pow << sample.bat << rowTime;
+}
 
+void SQLDriver::insertDatatoDataBase()
+{
     static qint64 last_sec = 0;
-    static bool next_insert = false;
-    static quint16 offset = 0;
 
-    const int maxPointSQLQuantity = 30;
+    if(rawData.length()<3) return;
+    // общее число точек переданных в запросе
+    quint16 cnt = static_cast<quint16>(static_cast<quint8>(rawData.at(1)))<<8 | static_cast<quint8>(rawData.at(2));
+    quint16 last_cnt = 0;
+    if(lastData.length()>=3) last_cnt = static_cast<quint16>(static_cast<quint8>(lastData.at(1)))<<8 | static_cast<quint8>(lastData.at(2));
+    if(rawData.length()<3+cnt*PointData::getRawDataSize()) return;
 
-    // запись по таймеру
-    if(QDateTime::currentSecsSinceEpoch()-last_sec>=10 || next_insert) {
+    // проверка всех точек по таймеру или при изменении числа точек
+    if(QDateTime::currentSecsSinceEpoch()-last_sec>=10 || cnt!=last_cnt) {
         last_sec = QDateTime::currentSecsSinceEpoch();
 
-        quint16 start_pos = 0;
-        // общее число точек переданных в запросе
-        // разбивается на несколько пакетов
-        quint16 end_pos = static_cast<quint16>(static_cast<quint16>(static_cast<quint8>(rawData.at(1)))<<8 | static_cast<quint8>(rawData.at(2)));
-        if(next_insert) {
-            start_pos = offset;
-        }
-        if(end_pos-start_pos>maxPointSQLQuantity) {
-            end_pos = start_pos+maxPointSQLQuantity;
-            offset = end_pos;
-            next_insert = true;
-        }else next_insert = false;
-        for(quint16 i=start_pos;i<end_pos;i++) {
-            if(rawData.length()<3+(i+1)*PointData::getRawDataSize()) return;
+        for(quint16 i=0;i<cnt;i++) {
             quint16 reg_offset = 3+i*PointData::getRawDataSize();
             PointData p(rawData.mid(reg_offset,PointData::getRawDataSize()));
             quint8 gr_num = p.getGroupNum();
-            quint8 point_num = p.getPointNum();
 
             if(gr_num && groupCorrectDataFlag.at(gr_num-1).has_value()) {
-                if(groupCorrectDataFlag.at(gr_num-1).value()) {
-                    acc = p.getAccumulatorVoltage();
-                    pow = p.getPowerVoltage();
-                    di1=p.getInput1String();
-                    di2=p.getInput2String();
-                    do1=p.getOutput1String();
-                    do2=p.getOutput2String();
-                    speaker = p.getSpeakerString();
-                }else {
-                    di1="нет данных";
-                    di2="нет данных";
-                    do1="нет данных";
-                    do2="нет данных";
-                    acc = 0;
-                    pow = 0;
-                    speaker = "нет данных";
-                    addPointAlarm(ip,point_num,gr_num,"нет данных", "авария");
-                }
-                QSqlQuery query;
-                query.prepare("INSERT INTO points (num, gate, di1, di2, do1, do2, speaker, pow, bat, ip)"
-                                                      "VALUES (:num, :gate, :di1, :di2, :do1, :do2, :speaker, :pow, :bat, :ip);");
-                query.bindValue(":num", point_num);
-                query.bindValue(":gate", gr_num);
-                query.bindValue(":di1", di1);
-                query.bindValue(":di2", di2);
-                query.bindValue(":do1", do1);
-                query.bindValue(":do2", do2);
-                query.bindValue(":speaker", speaker);
-                query.bindValue(":pow", pow);
-                query.bindValue(":bat", acc);
-                query.bindValue(":ip", ip);
-                query.exec();
-
-                bool alarmFlag = false;
-                if(p.getInput1()!=Input::UNUSED) {
-                    if(p.getInput1()==Input::BREAK) {alarmFlag=true;addPointAlarm(ip,point_num,gr_num,"Обрыв DI1", "авария");}
-                    else if(p.getInput1()==Input::SHORT) {alarmFlag=true;addPointAlarm(ip,point_num,gr_num,"Замыкание DI1", "авария");}
-                    else if(p.getInput1()==Input::OFF) {alarmFlag=true;addPointAlarm(ip,point_num,gr_num,"DI1 выкл", "авария");}
-                }
-                if(p.getInput2()!=Input::UNUSED) {
-                    if(p.getInput2()==Input::BREAK) {alarmFlag=true;addPointAlarm(ip,point_num,gr_num,"Обрыв DI2", "авария");}
-                    else if(p.getInput2()==Input::SHORT) {alarmFlag=true;addPointAlarm(ip,point_num,gr_num,"Замыкание DI2", "авария");}
-                    else if(p.getInput2()==Input::OFF) {alarmFlag=true;addPointAlarm(ip,point_num,gr_num,"DI2 выкл", "авария");}
-                }
-                if(p.getSpeaker()==Speaker::NOT_CHECKED) {addPointAlarm(ip,point_num,gr_num,"Динамики не проверялись", "предупреждение");}
-                else if(p.getSpeaker()==Speaker::PROBLEM) {alarmFlag=true;addPointAlarm(ip,point_num,gr_num,"Динамики не исправны", "авария");}
-
-                if(!alarmFlag) addPointAlarm(ip,point_num,gr_num,"параметры в норме", "сообщение");
+                bool noData = !groupCorrectDataFlag.at(gr_num-1).value();
+                // по таймеру пишутся точки, для которых истёк наибольший интервал записи
+                addPointRow(p,noData,true);
+                trackPointAlarms(p,noData);
             }
         }
     }else {
-        // запись по изменениям
-        // общее число точек переданных в запросе
-        quint16 cnt = static_cast<quint16>(static_cast<quint8>(rawData.at(1)))<<8 | static_cast<quint8>(rawData.at(2));
-        quint16 last_cnt = static_cast<quint16>(static_cast<quint8>(lastData.at(1)))<<8 | static_cast<quint8>(lastData.at(2));
-        // если число точек не поменялось
-        if(cnt==last_cnt) for(quint16 i=0;i<cnt;i++) {
-            if(rawData.length()<3+(i+1)*PointData::getRawDataSize()) return;
+        // запись по изменениям: разбираются только записи, значимые байты которых изменились
+        QBitArray changed = RecordDiff::changed(rawData,lastData,3,PointData::getRawDataSize(),cnt,pointMask);
+        for(quint16 i=0;i<cnt;i++) {
+            if(!changed.testBit(i)) continue;
             quint16 reg_offset = 3+i*PointData::getRawDataSize();
+            // на месте записи другая точка - её срез будет записан по таймеру
+            if(rawData.at(reg_offset)!=lastData.at(reg_offset) || rawData.at(reg_offset+1)!=lastData.at(reg_offset+1)) continue;
             PointData p(rawData.mid(reg_offset,PointData::getRawDataSize()));
             quint8 gr_num = p.getGroupNum();
-            quint8 point_num = p.getPointNum();
-
-            acc = p.getAccumulatorVoltage();
-            pow = p.getPowerVoltage();
-            di1=p.getInput1String();
-            di2=p.getInput2String();
-            do1=p.getOutput1String();
-            do2=p.getOutput2String();
-            speaker = p.getSpeakerString();
-
-
-
-            PointData pLast(lastData.mid(reg_offset,PointData::getRawDataSize()));
-            quint8 last_gr_num = pLast.getGroupNum();
-            quint8 last_point_num = pLast.getPointNum();
+            // без данных группы пишется "нет данных", оно не меняется от кадра к кадру
+            if(!gr_num || !groupCorrectDataFlag.at(gr_num-1).value_or(false)) continue;
 
-            if(gr_num && groupCorrectDataFlag.at(gr_num-1).has_value() && last_gr_num==gr_num && last_point_num==point_num) {
-                double last_acc, last_pow;
-                QString last_di1, last_di2, last_do1, last_do2,last_speaker;
-                QString last_gdi1, last_gdi2, last_gdi3, last_gdo1, last_gdo2;
-
-                if(gr_num && groupCorrectDataFlag.at(gr_num-1).value()) {
-
-                    last_acc = pLast.getAccumulatorVoltage();
-                    last_pow = pLast.getPowerVoltage();
-                    last_di1=pLast.getInput1String();
-                    last_di2=pLast.getInput2String();
-                    last_do1=pLast.getOutput1String();
-                    last_do2=pLast.getOutput2String();
-                    last_speaker = pLast.getSpeakerString();
-                }else {
-                    di1="нет данных";
-                    di2="нет данных";
-                    do1="нет данных";
-                    do2="нет данных";
-                    acc=0;
-                    pow=0;
-                    speaker = "нет данных";
-                    last_di1="нет данных";
-                    last_di2="нет данных";
-                    last_do1="нет данных";
-                    last_do2="нет данных";
-                    last_speaker = "нет данных";
-                    last_acc=0;
-                    last_pow=0;
-                }
-
-
-                if((last_acc!=acc)||(last_pow!=pow)||(di1!=last_di1)||(di2!=last_di2)||(do1!=last_do1)||(do2!=last_do2)||(speaker!=last_speaker)) {
-                    QSqlQuery query;
-                    query.prepare("INSERT INTO points (num, gate, di1, di2, do1, do2, speaker, pow, bat, ip)"
-                                                          "VALUES (:num, :gate, :di1, :di2, :do1, :do2, :speaker, :pow, :bat, :ip);");
-                    query.bindValue(":num", point_num);
-                    query.bindValue(":gate", gr_num);
-                    query.bindValue(":di1", di1);
-                    query.bindValue(":di2", di2);
-                    query.bindValue(":do1", do1);
-                    query.bindValue(":do2", do2);
-                    query.bindValue(":speaker", speaker);
-                    query.bindValue(":pow", pow);
-                    query.bindValue(":bat", acc);
-                    query.bindValue(":ip", ip);
-                    query.exec();
-
-                    if(last_di1!=di1) {
-                        if(di1=="обрыв") addPointAlarm(ip,point_num,gr_num,"Обрыв DI1", "авария");
-                        if(di1=="замыкание") addPointAlarm(ip,point_num,gr_num,"Замыкание DI1", "авария");
-                        if(di1=="выкл") addPointAlarm(ip,point_num,gr_num,"DI1 выкл", "авария");
-                        if(di1=="вкл") addPointAlarm(ip,point_num,gr_num,"DI1 вкл", "сообщение");
-                    }
-                    if(last_di2!=di2) {
-                        if(di2=="обрыв") addPointAlarm(ip,point_num,gr_num,"Обрыв DI2", "авария");
-                        if(di2=="замыкание") addPointAlarm(ip,point_num,gr_num,"Замыкание DI2", "авария");
-                        if(di2=="выкл") addPointAlarm(ip,point_num,gr_num,"DI2 выкл", "авария");
-                        if(di2=="вкл") addPointAlarm(ip,point_num,gr_num,"DI2 вкл", "сообщение");
-                    }
-                    if(last_speaker!=speaker) {
-                        if(speaker=="не проверялись") addPointAlarm(ip,point_num,gr_num,"Динамики не проверялись", "предупреждение");
-                        if(speaker=="не исправны") addPointAlarm(ip,point_num,gr_num,"Динамики не исправны", "авария");
-                        if(speaker=="исправны") addPointAlarm(ip,point_num,gr_num,"Динамики исправны", "сообщение");
-                    }
-                }
-            }
-
-        }else {
-            next_insert = true;
-            offset = 0;
+            addPointRow(p,false,false);
+            trackPointAlarms(p,false);
         }
     }
     lastData.clear();
@@ -273,7 +141,6 @@ void SQLDriver::insertDatatoDataBase()
 void SQLDriver::insertGroupDatatoDataBase()
 {
     QString gdi1,gdi2,gdi3,gdo1,gdo2;
-    QString last_gdi1, last_gdi2, last_gdi3, last_gdo1, last_gdo2;
     static qint64 last_sec = 0;
 
     // запись по таймеру
@@ -304,40 +171,28 @@ void SQLDriver::insertGroupDatatoDataBase()
                     gdo2="нет данных";
                 }
 
-                QSqlQuery query;
-                query.prepare("INSERT INTO gates (num, ip, cnt, di1, di2, di3, do1, do2)"
-                                                      "VALUES (:num, :ip, :cnt, :di1, :di2, :di3, :do1, :do2);");
-                query.bindValue(":num", i+1);
-                query.bindValue(":ip", ip);
-                query.bindValue(":cnt", cnt);
-                query.bindValue(":di1", gdi1);
-                query.bindValue(":di2", gdi2);
-                query.bindValue(":di3", gdi3);
-                query.bindValue(":do1", gdo1);
-                query.bindValue(":do2", gdo2);
-                query.exec();
-
-
-                if(gr.getNotActual()) {
-                    addGateAlarm(ip,i+1,"нет данных", "авария");
-                }else {
-                    if(cnt>=point_cnt.at(i)) {
-                        addGateAlarm(ip,i+1,"подключено " + QString::number(cnt) + " точек", "сообщение");
-                    }else {
-                        addGateAlarm(ip,i+1,"подключено " + QString::number(cnt) + " точек", "авария");
-                    }
+                gateRows << ip << i+1 << cnt << SQLSchema::stateCode(gdi1) << SQLSchema::stateCode(gdi2)
+                         << SQLSchema::stateCode(gdi3) << SQLSchema::stateCode(gdo1) << SQLSchema::stateCode(gdo2) << rowTime;
+
+
+                bool noData = gr.getNotActual();
+                if(!noData) gateRollup.add(i+1,0,{cnt,0},true,rowTime.toMSecsSinceEpoch());
+                trackGateAlarm(i+1,AlarmCondition::NO_DATA,noData,noData ? "нет данных" : "группа подключена",noData ? "авария" : "сообщение");
+                if(!noData) {
+                    bool lack = cnt<point_cnt.at(i);
+                    trackGateAlarm(i+1,AlarmCondition::POINTS,lack,"подключено " + QString::number(cnt) + " точек",lack ? "авария" : "сообщение");
                 }
             }
         }
     }else {
-        // запись по изменению
+        // запись по изменению: разбираются только записи, значимые байты которых изменились
         int length = rawGroupData.length()/GroupData::getRawGroupDataSize();
         int lastLength = lastGroupData.length()/GroupData::getRawGroupDataSize();
 
-        if(length==lastLength)
-        for(int i=0;i<length;i++) {
-            if(rawGroupData.length()<(i+1)*GroupData::getRawGroupDataSize()) return;
-            if(lastGroupData.length()<(i+1)*GroupData::getRawGroupDataSize()) return;
+        QBitArray changed;
+        if(length==lastLength) changed = RecordDiff::changed(rawGroupData,lastGroupData,0,GroupData::getRawGroupDataSize(),length,groupMask);
+        for(int i=0;i<changed.size();i++) {
+            if(!changed.testBit(i)) continue;
             quint16 offset = static_cast<quint16>(i*GroupData::getRawGroupDataSize());
             GroupData gr(rawGroupData.mid(offset,GroupData::getRawGroupDataSize()));
             GroupData grLast(lastGroupData.mid(offset,GroupData::getRawGroupDataSize()));
@@ -347,57 +202,28 @@ void SQLDriver::insertGroupDatatoDataBase()
                 uint8_t cnt = gr.getPointsQuantity();
                 uint8_t last_cnt = grLast.getPointsQuantity();
 
-                if(gnot_act) {
-                    groupCorrectDataFlag[i]=false;
-                    gdi1 = "нет данных";
-                    gdi2 = "нет данныхл";
-                    gdi3 = "нет данных";
-                    gdo1="выкл";
-                    gdo2="выкл";
-                    last_gdi1 = "нет данных";
-                    last_gdi2 = "нет данных";
-                    last_gdi3 = "нет данных";
-                    last_gdo1="нет данных";
-                    last_gdo2="нет данных";
-                }else {
-                    groupCorrectDataFlag[i]=true;
-                    gdi1 = gr.getInput1String();
-                    gdi2 = gr.getInput2String();
-                    gdi3 = gr.getInput3String();
-                    gdo1 = gr.getOut1String();
-                    gdo2 = gr.getOut2String();
-                    last_gdi1 = grLast.getInput1String();
-                    last_gdi2 = grLast.getInput2String();
-                    last_gdi3 = grLast.getInput3String();
-                    last_gdo1 = grLast.getOut1String();
-                    last_gdo2 = grLast.getOut2String();
-                }
-
-
-                if((gdi1!=last_gdi1)||(gdi2!=last_gdi2)||(gdi3!=last_gdi3)||(gdo1!=last_gdo1)||(gdo2!=last_gdo2)||(cnt!=last_cnt)||(gnot_act!=last_gnot_act)) {
-                    QSqlQuery query;
-                    query.prepare("INSERT INTO gates (num, ip, cnt, di1, di2, di3, do1, do2)"
-                                                          "VALUES (:num, :ip, :cnt, :di1, :di2, :di3, :do1, :do2);");
-                    query.bindValue(":num", i+1);
-                    query.bindValue(":ip", ip);
-                    query.bindValue(":cnt", cnt);
-                    query.bindValue(":di1", gdi1);
-                    query.bindValue(":di2", gdi2);
-                    query.bindValue(":di3", gdi3);
-                    query.bindValue(":do1", gdo1);
-                    query.bindValue(":do2", gdo2);
-                    query.exec();
+                groupCorrectDataFlag[i] = !gnot_act;
+                if(!gnot_act) gateRollup.add(i+1,0,{cnt,0},false,rowTime.toMSecsSinceEpoch());
+                // без данных группы строка та же, что и в прошлый раз
+                if(!(gnot_act && last_gnot_act)) {
+                    if(gnot_act) {
+                        gateRows << ip << i+1 << 0 << SQLSchema::stateCode("нет данных") << SQLSchema::stateCode("нет данных")
+                                 << SQLSchema::stateCode("нет данных") << SQLSchema::stateCode("нет данных") << SQLSchema::stateCode("нет данных") << rowTime;
+                    }else {
+                        gateRows << ip << i+1 << cnt << SQLSchema::stateCode(gr.getInput1String()) << SQLSchema::stateCode(gr.getInput2String())
+                                 << SQLSchema::stateCode(gr.getInput3String()) << SQLSchema::stateCode(gr.getOut1String()) << SQLSchema::stateCode(gr.getOut2String()) << rowTime;
+                    }
                 }
                 if(gnot_act==false) {
                     if(cnt!=last_cnt) {
                         if(cnt>=point_cnt.at(i)) {
                             QString message = "подключено " + QString::number(cnt) + " точек";
-                            addGateAlarm(ip,i+1,message, "сообщение");
+                            trackGateAlarm(i+1,AlarmCondition::POINTS,false,message,"сообщение");
                             QString journMessage = QString("группа ") + QString::number(gr.getGrNum()) + "   " + message;
                             insertMessage(journMessage, "сообщение");
                         }else {
                             QString message = "подключено " + QString::number(cnt) + " точек";
-                            addGateAlarm(ip,i+1,message, "авария");
+                            trackGateAlarm(i+1,AlarmCondition::POINTS,true,message,"авария");
                             QString journMessage = QString("группа ") + QString::number(gr.getGrNum()) + "   " + message;
                             insertMessage(journMessage, "авария");
                         }
@@ -406,11 +232,11 @@ void SQLDriver::insertGroupDatatoDataBase()
 
                 if(gnot_act!=last_gnot_act) {
                     if(gnot_act) {
-                        addGateAlarm(ip,i+1,"нет данных", "авария");
+                        trackGateAlarm(i+1,AlarmCondition::NO_DATA,true,"нет данных","авария");
                         QString journMessage = QString("группа ") + QString::number(gr.getGrNum()) + "нет данных";
                         insertMessage(journMessage, "авария");
                     }else {
-                        addGateAlarm(ip,i+1,"группа подключена", "сообщение");
+                        trackGateAlarm(i+1,AlarmCondition::NO_DATA,false,"группа подключена","сообщение");
                         QString journMessage = QString("группа ") + QString::number(gr.getGrNum()) + "группа подключена";
                         insertMessage(journMessage, "сообщение");
                     }
@@ -425,6 +251,7 @@ void SQLDriver::insertGroupDatatoDataBase()
 SQLDriver::SQLDriver(QObject *parent) : QObject(parent)
 {
     for(int i=0;i<32;i++) point_cnt.push_back(0);
+    spool = std::make_unique<SQLSpool>(SQLSpool::defaultDirName());
     std::fill(groupCorrectDataFlag.begin(),groupCorrectDataFlag.end(),std::nullopt);
 }
 
@@ -432,238 +259,722 @@ void SQLDriver::finish()
 {
     QMutexLocker locker(&mutex);
     finishFlag = true;
+    wake.wakeOne();
 }
 
 void SQLDriver::initDB()
 {
     QMutexLocker locker(&mutex);
     initFlag = true;
+    wake.wakeOne();
+}
+
+void SQLDriver::pushFrame(const QByteArray &data, bool group)
+{
+    // писатель не успевает - самый старый кадр вытесняется более свежими
+    if(frames.size()>=maxFrames) {
+        frames.pop_front();
+        coalescedFrames++;
+    }
+    Frame f;
+    f.data = data;
+    f.group = group;
+    f.time = QDateTime::currentMSecsSinceEpoch();
+    frames.push_back(f);
+    wake.wakeOne();
 }
 
 void SQLDriver::insertData(const QByteArray &data)
 {
     QMutexLocker locker(&mutex);
-    rawData.clear();
-    rawData.append(data);
-    insertFlag = true;
+    pushFrame(data,false);
 }
 
 void SQLDriver::insertGroupData(const QByteArray &data)
 {
     QMutexLocker locker(&mutex);
-    rawGroupData.clear();
-    rawGroupData.append(data);
-    insertGroupFlag = true;
+    pushFrame(data,true);
 }
 
 void SQLDriver::insertMessage(const QString &text, const QString &type)
 {
     QMutexLocker locker(&mutex);
+    // очередь журнала ограничена, при переполнении теряются самые старые сообщения
+    if(messages.size()>=maxMessages) {
+        messages.pop_front();
+        droppedMessages++;
+    }
     Message message;
     message.text = text;
     message.type = type;
+    message.time = QDateTime::currentMSecsSinceEpoch();
     messages.push_back(message);
+    wake.wakeOne();
 }
 
-void SQLDriver::updateJournal(const QDate &from, const QDate &to, QTableView *tv)
+void SQLDriver::acknowledgeAlarms()
 {
     QMutexLocker locker(&mutex);
+    ackFlag = true;
+    wake.wakeOne();
+}
 
-    journalQuery = "SELECT tmr,type,message FROM journal "
-            "where tmr between '";
-    journalQuery += from.toString(" yyyy-MM-dd 00:00:00");
-    journalQuery += "' and '";
-    journalQuery += to.toString(" yyyy-MM-dd 23:59:59");
-    journalQuery += "' ORDER BY id DESC;";
-    tv->setModel(journalModel);
+void SQLDriver::insertRecord(const RecordSegment &record)
+{
+    QMutexLocker locker(&mutex);
+    records.push_back(record);
+    wake.wakeOne();
 }
 
-void SQLDriver::updatePointArchive(const QDate &from, const QDate &to, QTableView *tv, int gr, int point)
+quint64 SQLDriver::getCommitCount() const
 {
     QMutexLocker locker(&mutex);
+    return commitCount;
+}
 
-    pointQuery = "SELECT tmr,di1,di2,do1,do2,pow,bat,speaker,ip FROM points "
-            "where tmr between '";
-    pointQuery += from.toString("yyyy-MM-dd 00:00:00");
-    pointQuery += "' and '";
-    pointQuery += to.toString("yyyy-MM-dd 23:59:59");
-    pointQuery += "' and gate="+QString::number(gr);
-    pointQuery += " and num="+QString::number(point);
-    pointQuery += " ORDER BY id DESC;";
-    tv->setModel(pointModel);
+quint64 SQLDriver::getWrittenRows() const
+{
+    QMutexLocker locker(&mutex);
+    return writtenRows;
 }
 
-void SQLDriver::updateGroupArchive(const QDate &from, const QDate &to, QTableView *tv, int gr)
+QDate SQLDriver::getRollupStart() const
 {
     QMutexLocker locker(&mutex);
+    return rollupStart;
+}
 
-    groupQuery = "SELECT tmr,cnt,di1,di2,di3,do1,do2,ip FROM gates "
-            "where tmr between '";
-    groupQuery += from.toString("yyyy-MM-dd 00:00:00");
-    groupQuery += "' and '";
-    groupQuery += to.toString("yyyy-MM-dd 23:59:59");
-    groupQuery += "' and num="+QString::number(gr);
-    groupQuery += " ORDER BY id DESC;";
-    tv->setModel(groupModel);
+void SQLDriver::addMessageToJournal()
+{
+    mutex.lock();
+    std::deque<Message> pending;
+    pending.swap(messages);
+    mutex.unlock();
+    for(const Message &m:pending) journalRows << m.text << m.type << QDateTime::fromMSecsSinceEpoch(m.time);
 }
 
-void SQLDriver::updatePointAlarmArchive(const QDate &from, const QDate &to, QTableView *tv, int gr, int point)
+void SQLDriver::addRecordsToCatalog()
 {
-    QMutexLocker locker(&mutex);
+    mutex.lock();
+    std::deque<RecordSegment> pending;
+    pending.swap(records);
+    mutex.unlock();
+    // смещения фрагмента в мс от начала файла: каждый фрагмент пишется в свой файл с нуля
+    for(const RecordSegment &r:pending) {
+        recordRows << r.key.gate << r.key.group << r.key.point << QDateTime::fromMSecsSinceEpoch(r.startTime)
+                   << r.duration << r.codec << r.fileName << qint64(0) << r.duration;
+    }
+}
 
-    pointAlarmQuery = "SELECT tmr,ip,type,alarm FROM point_alarms "
-            "where tmr between '";
-    pointAlarmQuery += from.toString("yyyy-MM-dd 00:00:00");
-    pointAlarmQuery += "' and '";
-    pointAlarmQuery += to.toString("yyyy-MM-dd 23:59:59");
-    pointAlarmQuery += "' and gate="+QString::number(gr);
-    pointAlarmQuery += " and point="+QString::number(point);
-    pointAlarmQuery += " ORDER BY id DESC;";
-    tv->setModel(pointAlarmModel);
+QString SQLDriver::inputAlarmText(const QString &name, Input input)
+{
+    switch(input) {
+        case Input::BREAK: return "Обрыв " + name;
+        case Input::SHORT: return "Замыкание " + name;
+        case Input::OFF: return name + " выкл";
+        case Input::ON: return name + " вкл";
+        default: return name + " не используется";
+    }
 }
 
-void SQLDriver::updateGroupAlarmArchive(const QDate &from, const QDate &to, QTableView *tv, int gr)
+void SQLDriver::trackPointAlarm(quint8 gate_num, quint8 point_num, AlarmCondition condition, bool active, const QString &message, const QString &type)
 {
-    QMutexLocker locker(&mutex);
+    // до чтения последнего среза переходы не известны: иначе активные тревоги записались бы повторно
+    if(restoredIp!=ip) return;
+    AlarmKey key{ip,gate_num,point_num,condition};
+    if(alarms.update(key,active,message,type,rowTime.toMSecsSinceEpoch())==AlarmTracker::Transition::NONE) return;
+    pointAlarmRows << message << type << point_num << gate_num << ip << rowTime;
+    pointRollup.alarm(gate_num,point_num,rowTime.toMSecsSinceEpoch());
+}
 
-    groupAlarmQuery = "SELECT tmr,ip,type,alarm FROM gate_alarms "
-            "where tmr between '";
-    groupAlarmQuery += from.toString("yyyy-MM-dd 00:00:00");
-    groupAlarmQuery += "' and '";
-    groupAlarmQuery += to.toString("yyyy-MM-dd 23:59:59");
-    groupAlarmQuery += "' and gate="+QString::number(gr);
-    groupAlarmQuery += " ORDER BY id DESC;";
-    tv->setModel(groupAlarmModel);
+void SQLDriver::trackGateAlarm(quint8 gate_num, AlarmCondition condition, bool active, const QString &message, const QString &type)
+{
+    if(restoredIp!=ip) return;
+    AlarmKey key{ip,gate_num,0,condition};
+    if(alarms.update(key,active,message,type,rowTime.toMSecsSinceEpoch())==AlarmTracker::Transition::NONE) return;
+    gateAlarmRows << message << type << gate_num << ip << rowTime;
+    gateRollup.alarm(gate_num,0,rowTime.toMSecsSinceEpoch());
 }
 
-void SQLDriver::addMessageToJournal()
+void SQLDriver::trackPointAlarms(const PointData &p, bool noData)
 {
-    mutex.lock();
-    if(!messages.empty()) {
-        Message m = messages.front();
-        QSqlQuery query;
-        query.prepare("INSERT INTO journal (message, type)"
-                      "VALUES (:message, :type);");
-        query.bindValue(":message", m.text);
-        query.bindValue(":type", m.type);
-        query.exec();
-        messages.pop_front();
+    quint8 gr_num = p.getGroupNum();
+    quint8 point_num = p.getPointNum();
+    trackPointAlarm(gr_num,point_num,AlarmCondition::NO_DATA,noData,noData ? "нет данных" : "данные получены",noData ? "авария" : "сообщение");
+    // без данных группы состояние входов неизвестно - тревоги входов остаются как были
+    if(noData) return;
+    Input di1 = p.getInput1();
+    bool di1Alarm = di1==Input::BREAK || di1==Input::SHORT || di1==Input::OFF;
+    trackPointAlarm(gr_num,point_num,AlarmCondition::DI1,di1Alarm,inputAlarmText("DI1",di1),di1Alarm ? "авария" : "сообщение");
+    Input di2 = p.getInput2();
+    bool di2Alarm = di2==Input::BREAK || di2==Input::SHORT || di2==Input::OFF;
+    trackPointAlarm(gr_num,point_num,AlarmCondition::DI2,di2Alarm,inputAlarmText("DI2",di2),di2Alarm ? "авария" : "сообщение");
+    Speaker speaker = p.getSpeaker();
+    if(speaker==Speaker::NOT_CHECKED) trackPointAlarm(gr_num,point_num,AlarmCondition::SPEAKER,true,"Динамики не проверялись","предупреждение");
+    else if(speaker==Speaker::PROBLEM) trackPointAlarm(gr_num,point_num,AlarmCondition::SPEAKER,true,"Динамики не исправны","авария");
+    else trackPointAlarm(gr_num,point_num,AlarmCondition::SPEAKER,false,"Динамики исправны","сообщение");
+}
+
+void SQLDriver::acknowledgeActiveAlarms()
+{
+    QDateTime now = QDateTime::currentDateTime();
+    for(const auto &a:alarms.acknowledge()) {
+        QString message = a.second.message + " - квитировано";
+        if(a.first.point) pointAlarmRows << message << "квитирование" << a.first.point << a.first.gate << a.first.ip << now;
+        else gateAlarmRows << message << "квитирование" << a.first.gate << a.first.ip << now;
+    }
+}
+
+void SQLDriver::snapshotAlarms()
+{
+    // срез активных тревог вместо повторения их в журнале тревог каждые 10 секунд
+    QDateTime now = QDateTime::currentDateTime();
+    bool current = false;
+    for(const auto &a:alarms.active()) {
+        snapshotRows << a.first.ip << a.first.gate << a.first.point << static_cast<int>(a.first.condition)
+                     << a.second.message << a.second.type << QDateTime::fromMSecsSinceEpoch(a.second.since) << a.second.acked << now;
+        if(a.first.ip==ip) current = true;
+    }
+    // пустой срез тоже записывается: иначе последним оказался бы срез с уже снятыми тревогами
+    // пока срез шлюза не прочитан, его состояние не известно и не записывается
+    if(!current && restoredIp==ip) snapshotRows << ip << 0 << 0 << QVariant() << QVariant() << QVariant() << now << false << now;
+}
+
+void SQLDriver::restoreAlarms()
+{
+    // после перезапуска активные тревоги не пишутся повторно, а снятые во время простоя получают запись о снятии
+    // срез в локальном журнале новее базы: чтение ждёт соединения и переноса журнала, попытка повторяется каждый проход
+    if(!db.isOpen() || !spool->isEmpty()) return;
+    QSqlQuery query(db);
+    query.prepare("SELECT gate, point, condition, alarm, type, since, acked FROM alarm_snapshots "
+                  "WHERE ip=? AND condition IS NOT NULL AND tmr=(SELECT max(tmr) FROM alarm_snapshots WHERE ip=?);");
+    query.addBindValue(ip);
+    query.addBindValue(ip);
+    if(!query.exec()) {
+        // обрыв - повтор после переподключения; ошибка самого запроса не должна навсегда остановить учёт тревог
+        if(connectionAlive()) restoredIp = ip;
+        else dropConnection();
+        return;
+    }
+    restoredIp = ip;
+    while(query.next()) {
+        int condition = query.value(2).toInt();
+        if(condition<0 || condition>static_cast<int>(AlarmCondition::POINTS)) continue;
+        AlarmKey key{ip,static_cast<quint8>(query.value(0).toInt()),static_cast<quint8>(query.value(1).toInt()),
+                     static_cast<AlarmCondition>(condition)};
+        AlarmState state;
+        state.message = query.value(3).toString();
+        state.type = query.value(4).toString();
+        state.since = query.value(5).toDateTime().toMSecsSinceEpoch();
+        state.acked = query.value(6).toBool();
+        alarms.restore(key,state);
     }
+}
+
+QSqlQuery &SQLDriver::prepared(const QString &sql)
+{
+    // подготовленные команды живут, пока открыто соединение
+    auto it = statements.find(sql);
+    if(it==statements.end()) {
+        auto query = std::make_unique<QSqlQuery>(db);
+        query->prepare(sql);
+        it = statements.emplace(sql,std::move(query)).first;
+    }
+    return *it->second;
+}
+
+void SQLDriver::maintainArchive()
+{
+    // раз в сутки: секции на следующие месяцы и удаление вышедших за срок хранения
+    if(maintenanceDate==QDate::currentDate()) return;
+    mutex.lock();
+    int months = archiveMonths;
     mutex.unlock();
+    // при ошибке следующая попытка на следующие сутки, чтобы не повторять сообщение каждый проход
+    maintenanceDate = QDate::currentDate();
+    QString schemaError;
+    if(!SQLSchema::maintain(db,months,schemaError)) emit error("ОШИБКА ОБСЛУЖИВАНИЯ АРХИВА: "+schemaError);
+    updateRollupStart();
 }
 
-void SQLDriver::addPointAlarm(const QString &ip_addr, quint8 point_num, quint8 gate_num, const QString &message, const QString &type)
+void SQLDriver::updateRollupStart()
 {
-    QSqlQuery query;
-    query.prepare("INSERT INTO point_alarms (alarm, type, point, gate, ip)"
-                                          "VALUES (:alarm, :type, :point, :gate, :ip);");
-    query.bindValue(":alarm", message);
-    query.bindValue(":type", type);
-    query.bindValue(":point", point_num);
-    query.bindValue(":gate", gate_num);
-    query.bindValue(":ip", ip_addr);
-    query.exec();
+    // агрегаты пишутся с перехода на них и удаляются вместе с архивом: более ранние интервалы есть только в исходных строках
+    // часовые агрегаты точек и групп начинаются одновременно, первые сутки неполные
+    QDate start;
+    QSqlQuery query(db);
+    for(const QString &table:{QString("points_rollup"),QString("gates_rollup")}) {
+        if(!query.exec("SELECT min(tmr) FROM " + table + " WHERE period=" + QString::number(Rollup::HOUR) + ";") ||
+           !query.next() || query.value(0).isNull()) {
+            start = QDate();
+            break;
+        }
+        QDateTime first = query.value(0).toDateTime();
+        QDate day = first.time()==QTime(0,0) ? first.date() : first.date().addDays(1);
+        if(!start.isValid() || day>start) start = day;
+    }
+    QMutexLocker locker(&mutex);
+    rollupStart = start;
 }
 
-void SQLDriver::addGateAlarm(const QString &ip_addr, quint8 gate_num, const QString &message, const QString &type)
+int SQLDriver::gatewayId(const QString &addr)
 {
-    QSqlQuery query;
-    query.prepare("INSERT INTO gate_alarms (alarm, type, gate, ip)"
-                                          "VALUES (:alarm, :type, :gate, :ip);");
-    query.bindValue(":alarm", message);
-    query.bindValue(":type", type);
-    query.bindValue(":gate", gate_num);
-    query.bindValue(":ip", ip_addr);
-    query.exec();
+    // номер шлюза в таблице gateways, в строках до записи хранится адрес
+    auto it = gateways.find(addr);
+    if(it!=gateways.end()) return it->second;
+    QSqlQuery &insert = prepared("INSERT INTO gateways (ip) VALUES (?) ON CONFLICT (ip) DO NOTHING;");
+    insert.addBindValue(addr);
+    insert.exec();
+    QSqlQuery &select = prepared("SELECT id FROM gateways WHERE ip=?;");
+    select.addBindValue(addr);
+    int id = 0;
+    if(select.exec() && select.next()) {
+        id = select.value(0).toInt();
+        gateways[addr] = id;
+    }
+    select.finish();
+    return id;
 }
 
-void SQLDriver::work()
+QString SQLDriver::tableHead(Table table)
 {
-    db = QSqlDatabase::addDatabase("QODBC");
-    for(;;) {
+    switch(table) {
+        case Table::POINTS: return "INSERT INTO points (gateway, gate, num, di1, di2, do1, do2, speaker, pow, bat, tmr)";
+        case Table::GATES: return "INSERT INTO gates (gateway, num, cnt, di1, di2, di3, do1, do2, tmr)";
+        case Table::POINT_ALARMS: return "INSERT INTO point_alarms (alarm, type, point, gate, ip, tmr)";
+        case Table::GATE_ALARMS: return "INSERT INTO gate_alarms (alarm, type, gate, ip, tmr)";
+        case Table::JOURNAL: return "INSERT INTO journal (message, type, tmr)";
+        case Table::RECORDS: return "INSERT INTO records (ip, gate, point, tmr, duration, codec, file, offset_start, offset_end)";
+        case Table::ALARM_SNAPSHOTS: return "INSERT INTO alarm_snapshots (ip, gate, point, condition, alarm, type, since, acked, tmr)";
+        case Table::POINT_ROLLUPS: return "INSERT INTO points_rollup (gateway, period, tmr, gate, num, samples, "
+                                          "pow_min, pow_max, pow_avg, pow_last, bat_min, bat_max, bat_avg, bat_last, alarms)";
+        case Table::GATE_ROLLUPS: return "INSERT INTO gates_rollup (gateway, period, tmr, num, samples, cnt_min, cnt_max, cnt_avg, cnt_last, alarms)";
+        default: return QString();
+    }
+}
+
+QString SQLDriver::currentTail(Table table)
+{
+    // строка из журнала, пришедшая после более новой, текущее состояние не перезаписывает
+    if(table==Table::POINTS) {
+        return " ON CONFLICT (gateway, gate, num) DO UPDATE SET di1=EXCLUDED.di1, di2=EXCLUDED.di2, do1=EXCLUDED.do1, "
+               "do2=EXCLUDED.do2, speaker=EXCLUDED.speaker, pow=EXCLUDED.pow, bat=EXCLUDED.bat, tmr=EXCLUDED.tmr "
+               "WHERE points_current.tmr<=EXCLUDED.tmr";
+    }
+    return " ON CONFLICT (gateway, num) DO UPDATE SET cnt=EXCLUDED.cnt, di1=EXCLUDED.di1, di2=EXCLUDED.di2, "
+           "di3=EXCLUDED.di3, do1=EXCLUDED.do1, do2=EXCLUDED.do2, tmr=EXCLUDED.tmr "
+           "WHERE gates_current.tmr<=EXCLUDED.tmr";
+}
+
+QString SQLDriver::rollupTail(Table table)
+{
+    // ячейка выгружается частями: части складываются, пустые значения не затирают накопленные
+    QString name;
+    QStringList channels;
+    QString key;
+    if(table==Table::POINT_ROLLUPS) {
+        name = "points_rollup";
+        channels << "pow" << "bat";
+        key = "period, gateway, gate, num, tmr";
+    }else if(table==Table::GATE_ROLLUPS) {
+        name = "gates_rollup";
+        channels << "cnt";
+        key = "period, gateway, num, tmr";
+    }else return QString();
+    QString sql = " ON CONFLICT (" + key + ") DO UPDATE SET samples=" + name + ".samples+EXCLUDED.samples, "
+                  "alarms=" + name + ".alarms+EXCLUDED.alarms";
+    for(const QString &c:channels) {
+        QString t = name + "." + c;
+        QString e = "EXCLUDED." + c;
+        sql += ", " + c + "_min=CASE WHEN " + t + "_min IS NULL OR " + e + "_min<" + t + "_min THEN " + e + "_min ELSE " + t + "_min END";
+        sql += ", " + c + "_max=CASE WHEN " + t + "_max IS NULL OR " + e + "_max>" + t + "_max THEN " + e + "_max ELSE " + t + "_max END";
+        sql += ", " + c + "_avg=CASE WHEN EXCLUDED.samples=0 THEN COALESCE(" + t + "_avg," + e + "_avg) "
+               "WHEN " + name + ".samples=0 OR " + t + "_avg IS NULL THEN " + e + "_avg "
+               "ELSE (" + t + "_avg*" + name + ".samples+" + e + "_avg*EXCLUDED.samples)/(" + name + ".samples+EXCLUDED.samples) END";
+        sql += ", " + c + "_last=COALESCE(" + e + "_last," + t + "_last)";
+    }
+    return sql;
+}
+
+bool SQLDriver::upsertCurrent(Table table, const QVariantList &values)
+{
+    // одна команда не может обновить строку дважды - из строк прохода по точке остаётся последняя
+    int columns = tableColumns(table);
+    int keyColumns = table==Table::POINTS ? 3 : 2;
+    int rows = values.size()/columns;
+    std::map<qint64,int> last;
+    for(int r=0;r<rows;r++) {
+        qint64 key = 0;
+        for(int k=0;k<keyColumns;k++) key = key<<16 | values.at(r*columns+k).toInt();
+        last[key] = r;
+    }
+    QVariantList current;
+    current.reserve(static_cast<int>(last.size())*columns);
+    for(const auto &l:last) {
+        for(int c=0;c<columns;c++) current << values.at(l.second*columns+c);
+    }
+    QString head = table==Table::POINTS ?
+                "INSERT INTO points_current (gateway, gate, num, di1, di2, do1, do2, speaker, pow, bat, tmr)" :
+                "INSERT INTO gates_current (gateway, num, cnt, di1, di2, di3, do1, do2, tmr)";
+    return insertValues(head,currentTail(table),columns,current);
+}
+
+int SQLDriver::tableColumns(Table table)
+{
+    switch(table) {
+        case Table::POINTS: return 11;
+        case Table::GATES: return 9;
+        case Table::POINT_ALARMS: return 6;
+        case Table::GATE_ALARMS: return 5;
+        case Table::JOURNAL: return 3;
+        case Table::RECORDS: return 9;
+        case Table::ALARM_SNAPSHOTS: return 9;
+        case Table::POINT_ROLLUPS: return 15;
+        case Table::GATE_ROLLUPS: return 10;
+        default: return 0;
+    }
+}
+
+QVariantList &SQLDriver::tableRows(Table table)
+{
+    switch(table) {
+        case Table::POINTS: return pointRows;
+        case Table::GATES: return gateRows;
+        case Table::POINT_ALARMS: return pointAlarmRows;
+        case Table::GATE_ALARMS: return gateAlarmRows;
+        case Table::JOURNAL: return journalRows;
+        case Table::ALARM_SNAPSHOTS: return snapshotRows;
+        case Table::POINT_ROLLUPS: return pointRollupRows;
+        case Table::GATE_ROLLUPS: return gateRollupRows;
+        default: return recordRows;
+    }
+}
+
+bool SQLDriver::insertRows(Table table, const QVariantList &values)
+{
+    int columns = tableColumns(table);
+    if(!columns) return true;
+    int rows = values.size()/columns;
+    QVariantList mapped;
+    const QVariantList *src = &values;
+    if(table==Table::POINTS || table==Table::GATES || table==Table::POINT_ROLLUPS || table==Table::GATE_ROLLUPS) {
+        mapped = values;
+        for(int i=0;i<rows;i++) mapped[i*columns] = gatewayId(values.at(i*columns).toString());
+        src = &mapped;
+    }
+    if(db.driverName()=="QSQLITE") {
+        // SQLite хранит время текстом: формат совпадает с CURRENT_TIMESTAMP, чтобы работали сравнения в запросах
+        if(src!=&mapped) mapped = values;
+        for(QVariant &v:mapped) if(v.type()==QVariant::DateTime) v = v.toDateTime().toString("yyyy-MM-dd hh:mm:ss.zzz");
+        src = &mapped;
+    }
+    if(!insertValues(tableHead(table),rollupTail(table),columns,*src)) return false;
+    // текущее состояние обновляется теми же строками в той же транзакции
+    if(table==Table::POINTS || table==Table::GATES) return upsertCurrent(table,*src);
+    return true;
+}
+
+bool SQLDriver::insertValues(const QString &head, const QString &tail, int columns, const QVariantList &values)
+{
+    int rows = values.size()/columns;
+    QString row = "(" + QString("?,").repeated(columns-1) + "?)";
+    int first = 0;
+    while(first<rows) {
+        // размеры пачек из фиксированного набора - на таблицу не больше четырёх подготовленных команд
+        int cnt = maxRowsPerInsert;
+        for(int size:{maxRowsPerInsert,100,10,1}) {
+            cnt = size;
+            if(size<=rows-first) break;
+        }
+        QString sql = head + " VALUES ";
+        for(int r=0;r<cnt;r++) {
+            if(r) sql += ",";
+            sql += row;
+        }
+        sql += tail;
+        QSqlQuery &query = prepared(sql);
+        for(int i=0;i<cnt*columns;i++) query.bindValue(i,values.at(first*columns+i));
+        if(!query.exec()) return false;
+        first += cnt;
+    }
+    return true;
+}
+
+bool SQLDriver::writeRows()
+{
+    // накопленные за проход строки уходят одной транзакцией, по одной команде на таблицу
+    int rows = 0;
+    for(int t=0;t<static_cast<int>(Table::COUNT);t++) rows += tableRows(static_cast<Table>(t)).size()/tableColumns(static_cast<Table>(t));
+    if(!rows) return true;
+    QElapsedTimer timer;
+    timer.start();
+    bool ok = db.transaction();
+    for(int t=0;t<static_cast<int>(Table::COUNT) && ok;t++) {
+        const QVariantList &values = tableRows(static_cast<Table>(t));
+        if(!values.isEmpty()) ok = insertRows(static_cast<Table>(t),values);
+    }
+    if(ok && db.commit()) {
+        addWriteTime(timer.elapsed());
         mutex.lock();
-        bool finishFlagState = finishFlag;
-        bool initFlagState = initFlag;
-        bool insertFlagState = insertFlag;
-        bool insertGroupFlagState = insertGroupFlag;
+        commitCount++;
+        writtenRows += static_cast<quint64>(rows);
         mutex.unlock();
-        if(initFlagState) {
-            mutex.lock();
-            initFlag = false;
-            mutex.unlock();
-            initDataBase();
-            if(finishFlagState) break;
-            QThread::msleep(1);
+        return true;
+    }
+    db.rollback();
+    // номер шлюза мог быть выдан в откатившейся транзакции
+    gateways.clear();
+    if(!connectionAlive()) {
+        dropConnection();
+        return false;
+    }
+    return writeRowsSeparately();
+}
+
+bool SQLDriver::writeTable(Table table, const QVariantList &values)
+{
+    bool ok = db.transaction() && insertRows(table,values);
+    if(ok && db.commit()) {
+        mutex.lock();
+        commitCount++;
+        writtenRows += static_cast<quint64>(values.size()/tableColumns(table));
+        mutex.unlock();
+        return true;
+    }
+    db.rollback();
+    gateways.clear();
+    return false;
+}
+
+bool SQLDriver::writeRowsSeparately()
+{
+    // пачка не принята: таблицы пишутся по отдельности, в отвергнутой таблице - по строке,
+    // пропускается только строка, которую база не принимает
+    // записанное убирается из буферов: при обрыве в локальный журнал уходит только остаток
+    for(int t=0;t<static_cast<int>(Table::COUNT);t++) {
+        Table table = static_cast<Table>(t);
+        QVariantList &values = tableRows(table);
+        if(values.isEmpty()) continue;
+        if(writeTable(table,values)) {
+            values.clear();
+            continue;
         }
-        if(insertFlagState && db.isOpen()) {
-            mutex.lock();
-            insertFlag = false;
-            mutex.unlock();
-            insertDatatoDataBase();
+        if(!connectionAlive()) {
+            dropConnection();
+            return false;
         }
-        if(insertGroupFlagState && db.isOpen()) {
-            mutex.lock();
-            insertGroupFlag = false;
-            mutex.unlock();
-            insertGroupDatatoDataBase();
+        int columns = tableColumns(table);
+        while(!values.isEmpty()) {
+            QVariantList row = values.mid(0,columns);
+            if(!writeTable(table,row)) {
+                if(!connectionAlive()) {
+                    dropConnection();
+                    return false;
+                }
+                rejectRows(1);
+            }
+            values.erase(values.begin(),values.begin()+columns);
         }
-        addMessageToJournal();
+    }
+    return true;
+}
+
+void SQLDriver::rejectRows(int rows)
+{
+    rejectedRows += static_cast<quint64>(rows);
+    rejectedPending += static_cast<quint64>(rows);
+    reportRejected();
+}
+
+void SQLDriver::reportRejected()
+{
+    // не чаще раза в период: постоянная ошибка данных не должна засыпать оператора сообщениями
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if(!rejectedPending || now-lastRejectReport<rejectReportPeriodMs) return;
+    emit error("СТРОКИ НЕ ПРИНЯТЫ БАЗОЙ ДАННЫХ И ПРОПУЩЕНЫ: " + QString::number(rejectedPending));
+    rejectedPending = 0;
+    lastRejectReport = now;
+}
+
+void SQLDriver::spoolRows()
+{
+    for(int t=0;t<static_cast<int>(Table::COUNT);t++) {
+        const QVariantList &values = tableRows(static_cast<Table>(t));
+        if(!values.isEmpty()) spool->append(t,values);
+    }
+}
+
+bool SQLDriver::replayBatch(int maxRows)
+{
+    int rows = 0;
+    int table;
+    QVariantList values;
+    QElapsedTimer timer;
+    timer.start();
+    bool ok = db.transaction();
+    while(ok && rows<maxRows && spool->next(table,values)) {
+        if(table<0 || table>=static_cast<int>(Table::COUNT)) continue;
+        ok = insertRows(static_cast<Table>(table),values);
+        rows += values.size()/tableColumns(static_cast<Table>(table));
+    }
+    if(ok && db.commit()) {
+        addWriteTime(timer.elapsed());
+        spool->commit();
         mutex.lock();
-        if(!journalQuery.isEmpty()) {
-            QSqlQuery query(journalQuery);
-            journalModel->setQuery(query);
-            journalModel->setHeaderData(0, Qt::Horizontal, tr("Время"));
-            journalModel->setHeaderData(1, Qt::Horizontal, tr("Тип"));
-            journalModel->setHeaderData(2, Qt::Horizontal, tr("Сообщение"));
-            journalQuery="";
+        commitCount++;
+        writtenRows += static_cast<quint64>(rows);
+        replayedRows += static_cast<quint64>(rows);
+        mutex.unlock();
+        return true;
+    }
+    db.rollback();
+    gateways.clear();
+    spool->rewind();
+    return false;
+}
+
+bool SQLDriver::replaySpool()
+{
+    // перенос накопленного за время недоступности базы большими транзакциями
+    if(spool->isEmpty() || replayBatch(replayRowsPerPass)) return true;
+    if(!connectionAlive()) {
+        dropConnection();
+        return false;
+    }
+    // в пачке есть строки, которые база не принимает: переносим по одной записи журнала до ошибочной
+    while(!spool->isEmpty()) {
+        if(replayBatch(1)) continue;
+        if(!connectionAlive()) {
+            dropConnection();
+            return false;
         }
-        if(!pointQuery.isEmpty()) {
-            QSqlQuery query(pointQuery);
-            pointModel->setQuery(query);
-            pointModel->setHeaderData(0, Qt::Horizontal, tr("Время"));
-            pointModel->setHeaderData(1, Qt::Horizontal, tr("Вход 1"));
-            pointModel->setHeaderData(2, Qt::Horizontal, tr("Вход 2"));
-            pointModel->setHeaderData(3, Qt::Horizontal, tr("Выход 1"));
-            pointModel->setHeaderData(4, Qt::Horizontal, tr("Выход 2"));
-            pointModel->setHeaderData(5, Qt::Horizontal, tr("Питание"));
-            pointModel->setHeaderData(6, Qt::Horizontal, tr("Аккумулятор"));
-            pointModel->setHeaderData(7, Qt::Horizontal, tr("Динамики"));
-            pointModel->setHeaderData(8, Qt::Horizontal, tr("IP"));
-            pointQuery="";
+        int table;
+        QVariantList values;
+        spool->next(table,values);
+        spool->commit();
+        if(table>=0 && table<static_cast<int>(Table::COUNT)) rejectRows(values.size()/tableColumns(static_cast<Table>(table)));
+        break;
+    }
+    return true;
+}
+
+void SQLDriver::addWriteTime(qint64 ms)
+{
+    writeTotalMs += ms;
+    writeMaxMs = qMax(writeMaxMs,ms);
+    writeCount++;
+}
+
+bool SQLDriver::connectionAlive()
+{
+    QSqlQuery query(db);
+    return query.exec("SELECT 1;");
+}
+
+void SQLDriver::dropConnection()
+{
+    statements.clear();
+    gateways.clear();
+    db.close();
+    connectionLost = true;
+    lastConnectAttempt = QDateTime::currentMSecsSinceEpoch();
+    emit error("СОЕДИНЕНИЕ С БАЗОЙ ДАННЫХ ПОТЕРЯНО, ДАННЫЕ СОХРАНЯЮТСЯ В ЛОКАЛЬНЫЙ ЖУРНАЛ");
+}
+
+void SQLDriver::work()
+{
+    qint64 lastMetricsTime = 0;
+    qint64 lastSnapshotTime = QDateTime::currentMSecsSinceEpoch();
+    qint64 lastRollupTime = lastSnapshotTime;
+    quint64 lastReplayedRows = 0;
+    for(;;) {
+        // соединение используется только этим потоком
+        bool replayRequest = db.isOpen() && !spool->isEmpty();
+        mutex.lock();
+        bool writeRequest = !frames.empty() || !messages.empty() || !records.empty() || ackFlag;
+        if(!finishFlag && !initFlag && !writeRequest && !replayRequest) wake.wait(&mutex,metricsPeriodMs);
+        bool finishFlagState = finishFlag;
+        bool initFlagState = initFlag;
+        initFlag = false;
+        bool ackFlagState = ackFlag;
+        ackFlag = false;
+        reportFilter.setSettings(reportSettings);
+        // забираем все накопленные кадры одной пачкой
+        std::deque<Frame> pendingFrames;
+        pendingFrames.swap(frames);
+        if(!pendingFrames.empty()) lagMs = QDateTime::currentMSecsSinceEpoch()-pendingFrames.front().time;
+        mutex.unlock();
+
+        if(initFlagState) initDataBase();
+        else if(connectionLost && QDateTime::currentMSecsSinceEpoch()-lastConnectAttempt>=reconnectPeriodMs) initDataBase();
+
+        if(restoredIp!=ip) restoreAlarms();
+        // строки собираются независимо от состояния базы, время каждой строки - время приёма кадра
+        for(const Frame &f:pendingFrames) {
+            rowTime = QDateTime::fromMSecsSinceEpoch(f.time);
+            if(f.group) {
+                rawGroupData = f.data;
+                insertGroupDatatoDataBase();
+            }else {
+                rawData = f.data;
+                insertDatatoDataBase();
+            }
         }
-        if(!groupQuery.isEmpty()) {
-            QSqlQuery query(groupQuery);
-            groupModel->setQuery(query);
-            groupModel->setHeaderData(0, Qt::Horizontal, tr("Время"));
-            groupModel->setHeaderData(1, Qt::Horizontal, tr("Подкл. точки"));
-            groupModel->setHeaderData(2, Qt::Horizontal, tr("Вход 1"));
-            groupModel->setHeaderData(3, Qt::Horizontal, tr("Вход 2"));
-            groupModel->setHeaderData(4, Qt::Horizontal, tr("Вход 3"));
-            groupModel->setHeaderData(5, Qt::Horizontal, tr("Выход 1"));
-            groupModel->setHeaderData(6, Qt::Horizontal, tr("Выход 2"));
-            groupModel->setHeaderData(7, Qt::Horizontal, tr("IP"));
-            groupQuery="";
+        // сообщения, добавленные при разборе кадров, попадают в ту же пачку
+        addMessageToJournal();
+        addRecordsToCatalog();
+        if(ackFlagState) acknowledgeActiveAlarms();
+        // срез при остановке - состояние, с которого продолжит следующий запуск
+        if(finishFlagState || QDateTime::currentMSecsSinceEpoch()-lastSnapshotTime>=snapshotPeriodMs) {
+            lastSnapshotTime = QDateTime::currentMSecsSinceEpoch();
+            snapshotAlarms();
         }
-        if(!groupAlarmQuery.isEmpty()) {
-            QSqlQuery query(groupAlarmQuery);
-            groupAlarmModel->setQuery(query);
-            groupAlarmModel->setHeaderData(0, Qt::Horizontal, tr("Время"));
-            groupModel->setHeaderData(1, Qt::Horizontal, tr("IP"));
-            groupAlarmModel->setHeaderData(2, Qt::Horizontal, tr("Тип"));
-            groupAlarmModel->setHeaderData(3, Qt::Horizontal, tr("Сообщение"));
-            groupAlarmQuery="";
+        // закрытые ячейки агрегатов - каждый проход, накопленное в открытых - периодически и при остановке
+        bool rollupAll = finishFlagState || QDateTime::currentMSecsSinceEpoch()-lastRollupTime>=rollupPeriodMs;
+        if(rollupAll) lastRollupTime = QDateTime::currentMSecsSinceEpoch();
+        pointRollup.flush(ip,pointRollupRows,rollupAll);
+        gateRollup.flush(ip,gateRollupRows,rollupAll);
+
+        bool written = false;
+        if(db.isOpen()) {
+            maintainArchive();
+            // сначала переносится журнал, чтобы не копить его при постоянном потоке новых строк
+            written = replaySpool() && writeRows();
         }
-        if(!pointAlarmQuery.isEmpty()) {
-            QSqlQuery query(pointAlarmQuery);
-            pointAlarmModel->setQuery(query);
-            pointAlarmModel->setHeaderData(0, Qt::Horizontal, tr("Время"));
-            pointAlarmModel->setHeaderData(1, Qt::Horizontal, tr("IP"));
-            pointAlarmModel->setHeaderData(2, Qt::Horizontal, tr("Тип"));
-            pointAlarmModel->setHeaderData(3, Qt::Horizontal, tr("Сообщение"));
-            pointAlarmQuery="";
+        if(!written) spoolRows();
+        reportRejected();
+        for(int t=0;t<static_cast<int>(Table::COUNT);t++) tableRows(static_cast<Table>(t)).clear();
+
+        qint64 now = QDateTime::currentMSecsSinceEpoch();
+        if(now-lastMetricsTime>=metricsPeriodMs) {
+            SQLMetrics m;
+            mutex.lock();
+            m.frameQueue = static_cast<int>(frames.size());
+            m.messageQueue = static_cast<int>(messages.size());
+            m.lagMs = lagMs;
+            m.coalescedFrames = coalescedFrames;
+            m.droppedMessages = droppedMessages;
+            m.commits = commitCount;
+            m.rows = writtenRows;
+            m.replayRate = (replayedRows-lastReplayedRows)*1000/static_cast<quint64>(qMax<qint64>(1,now-lastMetricsTime));
+            lastReplayedRows = replayedRows;
+            lagMs = 0;
+            mutex.unlock();
+            m.connected = db.isOpen();
+            m.spoolBytes = spool->pendingBytes();
+            m.alarmChecks = alarms.getChecks();
+            m.alarmRows = alarms.getTransitions();
+            m.filteredRows = reportFilter.getSuppressed();
+            m.writeAvgMs = writeCount ? writeTotalMs/writeCount : 0;
+            m.writeMaxMs = writeMaxMs;
+            m.rejectedRows = rejectedRows;
+            writeTotalMs = 0;
+            writeMaxMs = 0;
+            writeCount = 0;
+            lastMetricsTime = now;
+            emit metrics(m);
         }
-        mutex.unlock();
-        QThread::msleep(10);
+        if(finishFlagState) break;
     }
 }
 
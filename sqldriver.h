@@ -3,78 +3,195 @@
 
 #include <QObject>
 #include <QMutex>
+#include <QWaitCondition>
+#include <QDate>
+#include <QDateTime>
 #include "QtSql/QSqlDatabase"
 #include <deque>
-#include <QSqlQueryModel>
-#include <QTableView>
-#include "coloredsqlquerymodel.h"
 #include <array>
 #include <optional>
+#include <QVariantList>
+#include <QSqlQuery>
+#include <map>
+#include <memory>
+#include "recordwriter.h"
+#include "sqlspool.h"
+#include "projectconfig.h"
+#include "alarmtracker.h"
+#include "pointdata.h"
+#include "reportfilter.h"
+#include "rollup.h"
+
+// состояние очереди записи в базу
+struct SQLMetrics {
+    int frameQueue = 0;
+    int messageQueue = 0;
+    qint64 lagMs = 0;               // возраст самого старого кадра при разборе
+    quint64 coalescedFrames = 0;
+    quint64 droppedMessages = 0;
+    quint64 commits = 0;
+    quint64 rows = 0;
+    bool connected = false;
+    quint64 spoolBytes = 0;         // ждут переноса в базу из локального журнала
+    quint64 replayRate = 0;         // строк в секунду при переносе
+    quint64 alarmChecks = 0;        // проверок условий тревог
+    quint64 alarmRows = 0;          // из них записано переходов
+    quint64 filteredRows = 0;       // строк points, отброшенных зоной нечувствительности
+    qint64 writeAvgMs = 0;          // длительность транзакции записи за период
+    qint64 writeMaxMs = 0;
+    int archiveQueries = 0;         // запросов архива выполнялось в момент замера
+    quint64 rejectedRows = 0;       // строк, не принятых базой и пропущенных
+};
+Q_DECLARE_METATYPE(SQLMetrics)
 
 class SQLDriver : public QObject
 {
     struct Message {
         QString text;
         QString type;
+        qint64 time = 0;
+    };
+
+    // таблицы, строки которых копятся за проход и при недоступной базе уходят в локальный журнал
+    // номера пишутся в локальный журнал, новые таблицы добавляются перед COUNT
+    enum class Table {POINTS,GATES,POINT_ALARMS,GATE_ALARMS,JOURNAL,RECORDS,ALARM_SNAPSHOTS,POINT_ROLLUPS,GATE_ROLLUPS,COUNT};
+
+    struct Frame {
+        QByteArray data;
+        bool group = false;
+        qint64 time = 0;
     };
 
     Q_OBJECT
     QString ip;
+    std::map<QString,int> gateways;     // номера шлюзов в таблице gateways по адресу
+    DBSettings settings;
+    int archiveMonths = 12;
+    ReportSettings reportSettings;
+    ReportFilter reportFilter;
+    QDate maintenanceDate;
+    QDate rollupStart;                  // первые полные сутки агрегатов, защищено mutex
     std::vector<quint8> point_cnt;
     mutable QMutex mutex;
     bool finishFlag = false;
     bool initFlag = false;
-    bool insertFlag = false;
-    bool insertGroupFlag = false;
-    QString journalQuery;
-    QString pointQuery;
-    QString groupQuery;
-    QString pointAlarmQuery;
-    QString groupAlarmQuery;
+    bool ackFlag = false;
+    QWaitCondition wake;
+    std::deque<Frame> frames;
+    static const size_t maxFrames = 32;
+    static const size_t maxMessages = 1000;
+    static const int metricsPeriodMs = 1000;
+    quint64 coalescedFrames = 0;
+    quint64 droppedMessages = 0;
+    qint64 lagMs = 0;
     std::deque<Message> messages;
+    std::deque<RecordSegment> records;
     QByteArray rawData;
     QByteArray rawGroupData;
     QByteArray lastData;
     QByteArray lastGroupData;
+    static const QByteArray pointMask;
+    static const QByteArray groupMask;
     QSqlDatabase db;
     std::array<std::optional<bool>,256> groupCorrectDataFlag;
-    /*QSqlQueryModel *journalModel;
-    QSqlQueryModel *pointModel;
-    QSqlQueryModel *groupModel;
-    QSqlQueryModel *groupAlarmModel;
-    QSqlQueryModel *pointAlarmModel;*/
-    ColoredSqlQueryModel *journalModel=nullptr;
-    ColoredSqlQueryModel *pointModel=nullptr;
-    ColoredSqlQueryModel *groupModel=nullptr;
-    ColoredSqlQueryModel *groupAlarmModel=nullptr;
-    ColoredSqlQueryModel *pointAlarmModel=nullptr;
+    // строки текущего прохода, записываются многострочными INSERT
+    QVariantList pointRows;
+    QVariantList gateRows;
+    QVariantList pointAlarmRows;
+    QVariantList gateAlarmRows;
+    QVariantList journalRows;
+    QVariantList recordRows;
+    QVariantList snapshotRows;
+    QVariantList pointRollupRows;
+    QVariantList gateRollupRows;
+    Rollup pointRollup{2,true};
+    Rollup gateRollup{1,false};
+    static const int rollupPeriodMs = 5*60*1000;
+    AlarmTracker alarms;
+    static const int snapshotPeriodMs = 10*60*1000;
+    QString restoredIp;                 // шлюз, для которого уже прочитан последний срез тревог
+    QDateTime rowTime;                  // время приёма разбираемого кадра, пишется в tmr
+    std::unique_ptr<SQLSpool> spool;
+    bool connectionLost = false;
+    qint64 lastConnectAttempt = 0;
+    quint64 replayedRows = 0;
+    static const int reconnectPeriodMs = 5000;
+    static const int replayRowsPerPass = 20000;
+    static const int maxRowsPerInsert = 500;
+    std::map<QString,std::unique_ptr<QSqlQuery>> statements;
+    quint64 commitCount = 0;
+    quint64 writtenRows = 0;
+    quint64 rejectedRows = 0;
+    quint64 rejectedPending = 0;        // пропущенные строки, о которых ещё не сообщено
+    qint64 lastRejectReport = 0;
+    static const int rejectReportPeriodMs = 60000;
+    qint64 writeTotalMs = 0;            // транзакции записи с последнего замера
+    qint64 writeMaxMs = 0;
+    int writeCount = 0;
 
     void initDataBase();
     void insertDatatoDataBase();
     void insertGroupDatatoDataBase();
     void addMessageToJournal();
-    void addPointAlarm(const QString &ip_addr, quint8 point_num, quint8 gate_num, const QString &message, const QString &type);
-    void addGateAlarm(const QString &ip_addr, quint8 gate_num, const QString &message, const QString &type);
+    void pushFrame(const QByteArray &data, bool group);
+    void addRecordsToCatalog();
+    static QString inputAlarmText(const QString &name, Input input);
+    void trackPointAlarm(quint8 gate_num, quint8 point_num, AlarmCondition condition, bool active, const QString &message, const QString &type);
+    void trackGateAlarm(quint8 gate_num, AlarmCondition condition, bool active, const QString &message, const QString &type);
+    void trackPointAlarms(const PointData &p, bool noData);
+    void addPointRow(const PointData &p, bool noData, bool timer);
+    void acknowledgeActiveAlarms();
+    void snapshotAlarms();
+    void restoreAlarms();
+    QSqlQuery &prepared(const QString &sql);
+    int gatewayId(const QString &addr);
+    void maintainArchive();
+    void updateRollupStart();
+    static QString tableHead(Table table);
+    static int tableColumns(Table table);
+    QVariantList &tableRows(Table table);
+    bool insertRows(Table table, const QVariantList &values);
+    bool insertValues(const QString &head, const QString &tail, int columns, const QVariantList &values);
+    static QString currentTail(Table table);
+    static QString rollupTail(Table table);
+    bool upsertCurrent(Table table, const QVariantList &values);
+    bool writeRows();
+    bool writeTable(Table table, const QVariantList &values);
+    bool writeRowsSeparately();
+    void rejectRows(int rows);
+    void reportRejected();
+    void spoolRows();
+    bool replayBatch(int maxRows);
+    bool replaySpool();
+    bool connectionAlive();
+    void dropConnection();
+    void addWriteTime(qint64 ms);
 
 
 public:
     explicit SQLDriver(QObject *parent = nullptr);
+    // подключение с общими параметрами, при отсутствии QPSQL - через ODBC
+    static bool openDatabase(QSqlDatabase &db, const DBSettings &settings, const QString &connectionName);
     void finish();
     void initDB();
     void insertData(const QByteArray &data);
     void insertGroupData(const QByteArray &data);
     void insertMessage(const QString &text, const QString &type);
-    void setIP(const QString &value) {ip=value;}
+    void insertRecord(const RecordSegment &record);
+    void acknowledgeAlarms();
+    quint64 getCommitCount() const;
+    quint64 getWrittenRows() const;
+    QDate getRollupStart() const;
+    void setIP(const QString &value) {QMutexLocker locker(&mutex);ip=value;}
+    void setDBSettings(const DBSettings &value) {QMutexLocker locker(&mutex);settings=value;}
+    void setArchiveMonths(int value) {QMutexLocker locker(&mutex);archiveMonths=value;}
+    void setReportSettings(const ReportSettings &value) {QMutexLocker locker(&mutex);reportSettings=value;}
     void setPointCnt(quint8 grNum, quint8 value) {if(grNum<point_cnt.size()) point_cnt[grNum]=value;}
-    void updateJournal(const QDate &from, const QDate &to, QTableView *tv);
-    void updatePointArchive(const QDate &from, const QDate &to, QTableView *tv, int gr, int point);
-    void updateGroupArchive(const QDate &from, const QDate &to, QTableView *tv, int gr);
-    void updatePointAlarmArchive(const QDate &from, const QDate &to, QTableView *tv, int gr, int point);
-    void updateGroupAlarmArchive(const QDate &from, const QDate &to, QTableView *tv, int gr);
 
 signals:
     void error(const QString &message);
     void updateAlarmList(const QStringList &list);
+    void metrics(const SQLMetrics &m);
 public slots:
     void work();
 };
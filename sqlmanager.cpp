@@ -1,19 +1,42 @@
 #include "sqlmanager.h"
+#include "sqlschema.h"
 
 SQLManager::SQLManager(QObject *parent) : QObject(parent)
 {
+    qRegisterMetaType<SQLMetrics>("SQLMetrics");
+    qRegisterMetaType<ArchivePage>("ArchivePage");
     driver = new SQLDriver();
     driver->moveToThread(&sqlThread);
     connect(&sqlThread, &QThread::finished, driver, &QObject::deleteLater);
     connect(this, &SQLManager::init, driver, &SQLDriver::work);
     connect(driver,&SQLDriver::error,this,&SQLManager::error);
     connect(driver,&SQLDriver::updateAlarmList,this,&SQLManager::updateAlarmList);
+    connect(driver,&SQLDriver::metrics,this,&SQLManager::driverMetrics);
     sqlThread.start();
+
+    for(int i=0;i<readerCount;i++) {
+        readers[i] = new ArchiveReader("archive_"+QString::number(i));
+        readers[i]->moveToThread(&readerThreads[i]);
+        connect(&readerThreads[i], &QThread::finished, readers[i], &QObject::deleteLater);
+        connect(this, &SQLManager::init, readers[i], &ArchiveReader::work);
+        connect(readers[i],&ArchiveReader::error,this,&SQLManager::error);
+        connect(readers[i],&ArchiveReader::pageLoaded,this,&SQLManager::archivePage);
+    }
+    for(int i=0;i<ARCHIVE_CNT;i++) {
+        archives[i] = new ArchiveModel(i,this);
+        connect(archives[i],&ArchiveModel::pageRequested,this,&SQLManager::dispatchArchive);
+    }
+    for(QThread &t:readerThreads) t.start();
     emit init();
 }
 
 SQLManager::~SQLManager()
 {
+    for(int i=0;i<readerCount;i++) {
+        readers[i]->finish();
+        readerThreads[i].quit();
+        readerThreads[i].wait();
+    }
     driver->finish();
     sqlThread.quit();
     sqlThread.wait();
@@ -22,6 +45,7 @@ SQLManager::~SQLManager()
 void SQLManager::initDB()
 {
     driver->initDB();
+    for(ArchiveReader *r:readers) r->initDB();
 }
 
 void SQLManager::insertData(const QByteArray &data)
@@ -39,6 +63,11 @@ void SQLManager::insertMessage(const QString &text, const QString &type)
     driver->insertMessage(text,type);
 }
 
+void SQLManager::insertRecord(const RecordSegment &record)
+{
+    driver->insertRecord(record);
+}
+
 void SQLManager::setIP(const QString &value)
 {
     driver->setIP(value);
@@ -49,27 +78,123 @@ void SQLManager::setPointCnt(quint8 grNum, quint8 value)
     driver->setPointCnt(grNum,value);
 }
 
+void SQLManager::dispatchArchive(const ArchiveRequest &r)
+{
+    // поколение таблицы обновляется во всех читателях: прежний интервал отменяется, где бы он ни выполнялся
+    // зависший читатель занят и новых запросов не получает
+    ArchiveReader *target = readers[0];
+    int best = -1;
+    for(ArchiveReader *reader:readers) {
+        int load = reader->supersede(r.model,r.generation);
+        if(best<0 || load<best) {
+            best = load;
+            target = reader;
+        }
+    }
+    target->request(r);
+}
+
+void SQLManager::driverMetrics(const SQLMetrics &m)
+{
+    // задержка записи показывается вместе с числом идущих запросов архива
+    SQLMetrics full = m;
+    for(ArchiveReader *r:readers) if(r->isBusy()) full.archiveQueries++;
+    emit metrics(full);
+}
+
+void SQLManager::archivePage(const ArchivePage &page)
+{
+    if(page.model>=0 && page.model<ARCHIVE_CNT) archives[page.model]->pageLoaded(page);
+}
+
+QString SQLManager::interval(const QDate &from, const QDate &to)
+{
+    return "tmr between '" + from.toString("yyyy-MM-dd 00:00:00") + "' and '" + to.toString("yyyy-MM-dd 23:59:59") + "'";
+}
+
+int SQLManager::rollupPeriod(const QDate &from, const QDate &to) const
+{
+    // за длинный интервал - самый крупный агрегат, который даёт не меньше trendRows строк
+    qint64 days = from.daysTo(to)+1;
+    if(days<rawArchiveDays) return -1;
+    // интервал до начала агрегатов показывается исходными строками
+    QDate start = driver->getRollupStart();
+    if(!start.isValid() || from<start) return -1;
+    int period = Rollup::coarsest(days*86400/trendRows);
+    // минутные агрегаты хранятся только minuteRollupDays суток
+    if(period==Rollup::MINUTE && from<QDate::currentDate().addDays(-SQLSchema::minuteRollupDays)) period = Rollup::HOUR;
+    return period;
+}
+
 void SQLManager::updateJournal(const QDate &from, const QDate &to, QTableView *tv)
 {
-    driver->updateJournal(from,to,tv);
+    archives[JOURNAL]->setQuery("tmr,type,message","FROM journal where "+interval(from,to),
+                                {tr("Время"),tr("Тип"),tr("Сообщение")});
+    tv->setModel(archives[JOURNAL]);
 }
 
 void SQLManager::updatePointArchive(const QDate &from, const QDate &to, QTableView *tv, int gr, int point)
 {
-    driver->updatePointArchive(from,to,tv,gr,point);
+    int period = rollupPeriod(from,to);
+    if(period>=0) {
+        archives[POINTS]->setQuery("tmr,samples,pow_min,pow_max,pow_avg,pow_last,bat_min,bat_max,bat_avg,bat_last,alarms,ip",
+                                   "FROM points_rollup_text where period="+QString::number(period)+" and "+interval(from,to)+
+                                   " and gate="+QString::number(gr)+" and num="+QString::number(point),
+                                   {tr("Начало периода"),tr("Отсчётов"),tr("Питание мин."),tr("Питание макс."),
+                                    tr("Питание ср."),tr("Питание посл."),tr("Аккумулятор мин."),tr("Аккумулятор макс."),
+                                    tr("Аккумулятор ср."),tr("Аккумулятор посл."),tr("Тревог"),tr("IP")});
+        tv->setModel(archives[POINTS]);
+        return;
+    }
+    archives[POINTS]->setQuery("tmr,di1,di2,do1,do2,pow,bat,speaker,ip",
+                               "FROM points_text where "+interval(from,to)+
+                               " and gate="+QString::number(gr)+" and num="+QString::number(point),
+                               {tr("Время"),tr("Вход 1"),tr("Вход 2"),tr("Выход 1"),tr("Выход 2"),
+                                tr("Питание"),tr("Аккумулятор"),tr("Динамики"),tr("IP")});
+    tv->setModel(archives[POINTS]);
 }
 
 void SQLManager::updateGroupArchive(const QDate &from, const QDate &to, QTableView *tv, int gr)
 {
-    driver->updateGroupArchive(from,to,tv,gr);
+    int period = rollupPeriod(from,to);
+    if(period>=0) {
+        archives[GROUPS]->setQuery("tmr,samples,cnt_min,cnt_max,cnt_avg,cnt_last,alarms,ip",
+                                   "FROM gates_rollup_text where period="+QString::number(period)+" and "+interval(from,to)+
+                                   " and num="+QString::number(gr),
+                                   {tr("Начало периода"),tr("Отсчётов"),tr("Подкл. точки мин."),tr("Подкл. точки макс."),
+                                    tr("Подкл. точки ср."),tr("Подкл. точки посл."),tr("Тревог"),tr("IP")});
+        tv->setModel(archives[GROUPS]);
+        return;
+    }
+    archives[GROUPS]->setQuery("tmr,cnt,di1,di2,di3,do1,do2,ip",
+                               "FROM gates_text where "+interval(from,to)+" and num="+QString::number(gr),
+                               {tr("Время"),tr("Подкл. точки"),tr("Вход 1"),tr("Вход 2"),tr("Вход 3"),
+                                tr("Выход 1"),tr("Выход 2"),tr("IP")});
+    tv->setModel(archives[GROUPS]);
 }
 
 void SQLManager::updatePointAlarmArchive(const QDate &from, const QDate &to, QTableView *tv, int gr, int point)
 {
-    driver->updatePointAlarmArchive(from,to,tv,gr,point);
+    archives[POINT_ALARMS]->setQuery("tmr,ip,type,alarm",
+                                     "FROM point_alarms where "+interval(from,to)+
+                                     " and gate="+QString::number(gr)+" and point="+QString::number(point),
+                                     {tr("Время"),tr("IP"),tr("Тип"),tr("Сообщение")});
+    tv->setModel(archives[POINT_ALARMS]);
 }
 
 void SQLManager::updateGroupAlarmArchive(const QDate &from, const QDate &to, QTableView *tv, int gr)
 {
-    driver->updateGroupAlarmArchive(from,to,tv,gr);
+    archives[GROUP_ALARMS]->setQuery("tmr,ip,type,alarm",
+                                     "FROM gate_alarms where "+interval(from,to)+" and gate="+QString::number(gr),
+                                     {tr("Время"),tr("IP"),tr("Тип"),tr("Сообщение")});
+    tv->setModel(archives[GROUP_ALARMS]);
+}
+
+void SQLManager::updateRecordArchive(const QDate &from, const QDate &to, QTableView *tv, int gr, int point)
+{
+    archives[RECORDS]->setQuery("tmr,ip,duration/1000,codec,file",
+                                "FROM records where gate="+QString::number(gr)+" and point="+QString::number(point)+
+                                " and "+interval(from,to),
+                                {tr("Время"),tr("IP"),tr("Длительность, с"),tr("Формат"),tr("Файл")});
+    tv->setModel(archives[RECORDS]);
 }
@@ -4,12 +4,31 @@
 #include <QObject>
 #include "sqldriver.h"
 #include <QThread>
+#include <QTableView>
+#include <array>
+#include "archivemodel.h"
+#include "archivereader.h"
 
 class SQLManager : public QObject
 {
     Q_OBJECT
     SQLDriver *driver;
     QThread sqlThread;
+    // пул чтения архива: у каждого читателя свой поток и соединение, запрос получает наименее занятый
+    static const int readerCount = 2;
+    std::array<ArchiveReader*,readerCount> readers;
+    std::array<QThread,readerCount> readerThreads;
+    enum {JOURNAL,POINTS,GROUPS,POINT_ALARMS,GROUP_ALARMS,RECORDS,ARCHIVE_CNT};
+    // модели живут в потоке интерфейса, страницы загружает поток чтения архива
+    std::array<ArchiveModel*,ARCHIVE_CNT> archives;
+    static QString interval(const QDate &from, const QDate &to);
+    // с интервала в rawArchiveDays суток архив точек и групп показывается агрегатами
+    static const int rawArchiveDays = 7;
+    static const int trendRows = 1000;
+    int rollupPeriod(const QDate &from, const QDate &to) const;
+    void archivePage(const ArchivePage &page);
+    void driverMetrics(const SQLMetrics &m);
+    void dispatchArchive(const ArchiveRequest &r);
 public:
     explicit SQLManager(QObject *parent = nullptr);
     ~SQLManager();
@@ -17,18 +36,27 @@ public:
     void insertData(const QByteArray &data);
     void insertGroupData(const QByteArray &data);
     void insertMessage(const QString &text, const QString &type);
+    void insertRecord(const RecordSegment &record);
+    void acknowledgeAlarms() {driver->acknowledgeAlarms();}
+    quint64 getCommitCount() const {return driver->getCommitCount();}
+    quint64 getWrittenRows() const {return driver->getWrittenRows();}
     void setIP(const QString &value);
+    void setDBSettings(const DBSettings &value) {driver->setDBSettings(value);for(ArchiveReader *r:readers) r->setDBSettings(value);}
+    void setArchiveMonths(int value) {driver->setArchiveMonths(value);}
+    void setReportSettings(const ReportSettings &value) {driver->setReportSettings(value);}
     void setPointCnt(quint8 grNum, quint8 value);
     void updateJournal(const QDate &from, const QDate &to, QTableView *tv);
     void updatePointArchive(const QDate &from, const QDate &to, QTableView *tv, int gr, int point);
     void updateGroupArchive(const QDate &from, const QDate &to, QTableView *tv, int gr);
     void updatePointAlarmArchive(const QDate &from, const QDate &to, QTableView *tv, int gr, int point);
     void updateGroupAlarmArchive(const QDate &from, const QDate &to, QTableView *tv, int gr);
+    void updateRecordArchive(const QDate &from, const QDate &to, QTableView *tv, int gr, int point);
 
 signals:
     void init();
     void error(const QString &message);
     void updateAlarmList(const QStringList &list);
+    void metrics(const SQLMetrics &m);
 
 public slots:
 };
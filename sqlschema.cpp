@@ -0,0 +1,407 @@
+#include "sqlschema.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QSqlRecord>
+#include <QVariant>
+
+// индекс в списке - код состояния в базе, неизвестное значение хранится как -1 ("-")
+const QStringList SQLSchema::stateNames = {"вкл","выкл","замыкание","обрыв","не используется",
+                                           "нет данных","не проверялись","исправны","не исправны"};
+
+const QStringList SQLSchema::partitionedTables = {"points","gates","point_alarms","gate_alarms","journal","alarm_snapshots"};
+
+qint16 SQLSchema::stateCode(const QString &name)
+{
+    return static_cast<qint16>(stateNames.indexOf(name));
+}
+
+QString SQLSchema::stateNameSql(const QString &column)
+{
+    QString sql = "CASE " + column;
+    for(int i=0;i<stateNames.size();i++) sql += " WHEN " + QString::number(i) + " THEN '" + stateNames.at(i) + "'";
+    sql += " ELSE '-' END";
+    return sql;
+}
+
+QString SQLSchema::stateCodeSql(const QString &column)
+{
+    QString sql = "CASE " + column;
+    for(int i=0;i<stateNames.size();i++) sql += " WHEN '" + stateNames.at(i) + "' THEN " + QString::number(i);
+    sql += " ELSE -1 END";
+    return sql;
+}
+
+bool SQLSchema::exec(QSqlDatabase &db, const QString &sql, QString &error)
+{
+    QSqlQuery query(db);
+    if(!query.exec(sql)) {
+        error = query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+int SQLSchema::currentVersion(QSqlDatabase &db)
+{
+    QSqlQuery query(db);
+    if(query.exec("SELECT max(version) FROM schema_version;") && query.next() && !query.value(0).isNull()) {
+        return query.value(0).toInt();
+    }
+    // версия не записана: таблица points с текстовыми полями - первая версия схемы
+    return db.tables().contains("points") ? 1 : 0;
+}
+
+bool SQLSchema::isSQLite(const QSqlDatabase &db)
+{
+    return db.driverName()=="QSQLITE";
+}
+
+bool SQLSchema::createTables(QSqlDatabase &db, QString &error)
+{
+    // SQLite: номер строки вместо последовательности, без секций и BRIN
+    bool sqlite = isSQLite(db);
+    QString serial = sqlite ? "id INTEGER PRIMARY KEY," : "id SERIAL PRIMARY KEY NOT NULL,";
+    // ключ секционированной таблицы обязан включать tmr
+    QString partSerial = sqlite ? "id INTEGER PRIMARY KEY," : "id SERIAL NOT NULL,";
+    QString partEnd = sqlite ? ");" : ",PRIMARY KEY (id, tmr)) PARTITION BY RANGE (tmr);";
+    QString timeIndex = sqlite ? " (tmr);" : " USING BRIN (tmr);";
+
+    QStringList sql;
+    sql << "CREATE TABLE IF NOT EXISTS gateways (" + serial +
+           "ip TEXT NOT NULL UNIQUE"
+           ");";
+    // поля упорядочены по размеру, чтобы не было выравнивания
+    sql << "CREATE TABLE IF NOT EXISTS points (" + partSerial +
+           "tmr TIMESTAMP DEFAULT CURRENT_TIMESTAMP NOT NULL,"
+           "gateway smallint NOT NULL,"
+           "gate smallint NOT NULL,"
+           "num smallint NOT NULL,"
+           "di1 smallint NOT NULL,"
+           "di2 smallint NOT NULL,"
+           "do1 smallint NOT NULL,"
+           "do2 smallint NOT NULL,"
+           "speaker smallint NOT NULL,"
+           "pow smallint NOT NULL,"     // 0.1 В
+           "bat smallint NOT NULL"      // 0.1 В
+           + partEnd;
+    sql << "CREATE TABLE IF NOT EXISTS gates (" + partSerial +
+           "tmr TIMESTAMP DEFAULT CURRENT_TIMESTAMP NOT NULL,"
+           "gateway smallint NOT NULL,"
+           "num smallint NOT NULL,"
+           "cnt smallint NOT NULL,"
+           "di1 smallint NOT NULL,"
+           "di2 smallint NOT NULL,"
+           "di3 smallint NOT NULL,"
+           "do1 smallint NOT NULL,"
+           "do2 smallint NOT NULL"
+           + partEnd;
+    sql << "CREATE TABLE IF NOT EXISTS point_alarms (" + partSerial +
+           "alarm TEXT,"
+           "type TEXT,"
+           "point smallint NOT NULL,"
+           "gate smallint NOT NULL,"
+           "ip TEXT NOT NULL,"
+           "tmr TIMESTAMP DEFAULT CURRENT_TIMESTAMP NOT NULL"
+           + partEnd;
+    sql << "CREATE TABLE IF NOT EXISTS gate_alarms (" + partSerial +
+           "alarm TEXT,"
+           "type TEXT,"
+           "gate smallint NOT NULL,"
+           "ip TEXT NOT NULL,"
+           "tmr TIMESTAMP DEFAULT CURRENT_TIMESTAMP NOT NULL"
+           + partEnd;
+    sql << "CREATE TABLE IF NOT EXISTS journal (" + partSerial +
+           "message VARCHAR(64),"
+           "type TEXT,"
+           "tmr TIMESTAMP DEFAULT CURRENT_TIMESTAMP NOT NULL"
+           + partEnd;
+    // текущее состояние: по строке на точку и группу, обновляется вместе с записью истории
+    // заполняется при записи, каждая точка пишется не реже наибольшего интервала записи
+    sql << "CREATE TABLE IF NOT EXISTS points_current ("
+           "tmr TIMESTAMP NOT NULL,"
+           "gateway smallint NOT NULL,"
+           "gate smallint NOT NULL,"
+           "num smallint NOT NULL,"
+           "di1 smallint NOT NULL,"
+           "di2 smallint NOT NULL,"
+           "do1 smallint NOT NULL,"
+           "do2 smallint NOT NULL,"
+           "speaker smallint NOT NULL,"
+           "pow smallint NOT NULL,"
+           "bat smallint NOT NULL,"
+           "PRIMARY KEY (gateway, gate, num));";
+    sql << "CREATE TABLE IF NOT EXISTS gates_current ("
+           "tmr TIMESTAMP NOT NULL,"
+           "gateway smallint NOT NULL,"
+           "num smallint NOT NULL,"
+           "cnt smallint NOT NULL,"
+           "di1 smallint NOT NULL,"
+           "di2 smallint NOT NULL,"
+           "di3 smallint NOT NULL,"
+           "do1 smallint NOT NULL,"
+           "do2 smallint NOT NULL,"
+           "PRIMARY KEY (gateway, num));";
+    // агрегаты за минуту, час и сутки (period 0, 1, 2) для запросов за длинные интервалы
+    sql << "CREATE TABLE IF NOT EXISTS points_rollup (" + serial +
+           "tmr TIMESTAMP NOT NULL,"        // начало периода
+           "gateway smallint NOT NULL,"
+           "period smallint NOT NULL,"
+           "gate smallint NOT NULL,"
+           "num smallint NOT NULL,"
+           "samples INTEGER NOT NULL,"      // отсчётов в среднем
+           "pow_min smallint,"
+           "pow_max smallint,"
+           "pow_avg REAL,"
+           "pow_last smallint,"
+           "bat_min smallint,"
+           "bat_max smallint,"
+           "bat_avg REAL,"
+           "bat_last smallint,"
+           "alarms INTEGER NOT NULL,"       // переходов тревог
+           "UNIQUE (period, gateway, gate, num, tmr));";
+    sql << "CREATE TABLE IF NOT EXISTS gates_rollup (" + serial +
+           "tmr TIMESTAMP NOT NULL,"
+           "gateway smallint NOT NULL,"
+           "period smallint NOT NULL,"
+           "num smallint NOT NULL,"
+           "samples INTEGER NOT NULL,"
+           "cnt_min smallint,"
+           "cnt_max smallint,"
+           "cnt_avg REAL,"
+           "cnt_last smallint,"
+           "alarms INTEGER NOT NULL,"
+           "UNIQUE (period, gateway, num, tmr));";
+    // периодический срез активных тревог, сам журнал тревог хранит только переходы
+    sql << "CREATE TABLE IF NOT EXISTS alarm_snapshots (" + partSerial +
+           "ip TEXT NOT NULL,"
+           "gate smallint NOT NULL,"
+           "point smallint NOT NULL,"   // 0 - тревога группы
+           "condition smallint,"        // AlarmCondition, пусто - срез без активных тревог шлюза
+           "alarm TEXT,"
+           "type TEXT,"
+           "since TIMESTAMP NOT NULL,"
+           "acked BOOLEAN NOT NULL,"
+           "tmr TIMESTAMP DEFAULT CURRENT_TIMESTAMP NOT NULL"
+           + partEnd;
+    // каталог аудиозаписей
+    sql << "CREATE TABLE IF NOT EXISTS records (" + serial +
+           "ip TEXT NOT NULL,"
+           "gate smallint NOT NULL,"
+           "point smallint NOT NULL,"
+           "tmr TIMESTAMP NOT NULL,"
+           "duration INTEGER NOT NULL,"
+           "codec TEXT NOT NULL,"
+           "file TEXT NOT NULL,"
+           "offset_start BIGINT NOT NULL,"     // мс от начала файла
+           "offset_end BIGINT NOT NULL"
+           ");";
+
+    // архивные запросы фильтруют по точке и интервалу времени и сортируют по времени
+    sql << "CREATE INDEX IF NOT EXISTS points_gate_num_tmr_idx ON points (gate, num, tmr);";
+    sql << "CREATE INDEX IF NOT EXISTS gates_num_tmr_idx ON gates (num, tmr);";
+    sql << "CREATE INDEX IF NOT EXISTS point_alarms_gate_point_tmr_idx ON point_alarms (gate, point, tmr);";
+    sql << "CREATE INDEX IF NOT EXISTS gate_alarms_gate_tmr_idx ON gate_alarms (gate, tmr);";
+    // строки пишутся по возрастанию времени - BRIN занимает несколько страниц на месяц данных
+    sql << "CREATE INDEX IF NOT EXISTS points_tmr_brin ON points" + timeIndex;
+    sql << "CREATE INDEX IF NOT EXISTS gates_tmr_brin ON gates" + timeIndex;
+    sql << "CREATE INDEX IF NOT EXISTS journal_tmr_brin ON journal" + timeIndex;
+    sql << "CREATE INDEX IF NOT EXISTS alarm_snapshots_tmr_brin ON alarm_snapshots" + timeIndex;
+    // последний срез шлюза читается при запуске
+    sql << "CREATE INDEX IF NOT EXISTS alarm_snapshots_ip_tmr_idx ON alarm_snapshots (ip, tmr);";
+    sql << "CREATE INDEX IF NOT EXISTS records_gate_point_tmr_idx ON records (gate, point, tmr);";
+    sql << "CREATE INDEX IF NOT EXISTS records_tmr_idx ON records (tmr);";
+    sql << "CREATE INDEX IF NOT EXISTS points_rollup_period_gate_num_tmr_idx ON points_rollup (period, gate, num, tmr);";
+    sql << "CREATE INDEX IF NOT EXISTS gates_rollup_period_num_tmr_idx ON gates_rollup (period, num, tmr);";
+
+    // в SQLite нет CREATE OR REPLACE VIEW
+    QString view = sqlite ? "CREATE VIEW " : "CREATE OR REPLACE VIEW ";
+    if(sqlite) sql << "DROP VIEW IF EXISTS points_text;" << "DROP VIEW IF EXISTS gates_text;"
+                   << "DROP VIEW IF EXISTS points_current_text;" << "DROP VIEW IF EXISTS points_rollup_text;"
+                   << "DROP VIEW IF EXISTS gates_rollup_text;";
+    sql << view + "points_text AS SELECT p.id, p.tmr, p.gate, p.num, " +
+           stateNameSql("p.di1") + " AS di1, " + stateNameSql("p.di2") + " AS di2, " +
+           stateNameSql("p.do1") + " AS do1, " + stateNameSql("p.do2") + " AS do2, " +
+           stateNameSql("p.speaker") + " AS speaker, "
+           "round(p.pow/10.0,1) AS pow, round(p.bat/10.0,1) AS bat, g.ip "
+           "FROM points p LEFT JOIN gateways g ON g.id=p.gateway;";
+    sql << view + "gates_text AS SELECT t.id, t.tmr, t.num, t.cnt, " +
+           stateNameSql("t.di1") + " AS di1, " + stateNameSql("t.di2") + " AS di2, " +
+           stateNameSql("t.di3") + " AS di3, " + stateNameSql("t.do1") + " AS do1, " +
+           stateNameSql("t.do2") + " AS do2, g.ip "
+           "FROM gates t LEFT JOIN gateways g ON g.id=t.gateway;";
+    sql << view + "points_current_text AS SELECT p.tmr, p.gate, p.num, " +
+           stateNameSql("p.di1") + " AS di1, " + stateNameSql("p.di2") + " AS di2, " +
+           stateNameSql("p.do1") + " AS do1, " + stateNameSql("p.do2") + " AS do2, " +
+           stateNameSql("p.speaker") + " AS speaker, "
+           "round(p.pow/10.0,1) AS pow, round(p.bat/10.0,1) AS bat, g.ip "
+           "FROM points_current p LEFT JOIN gateways g ON g.id=p.gateway;";
+    sql << view + "points_rollup_text AS SELECT r.id, r.tmr, r.period, r.gate, r.num, r.samples, "
+           "round(r.pow_min/10.0,1) AS pow_min, round(r.pow_max/10.0,1) AS pow_max, "
+           "round(CAST(r.pow_avg/10.0 AS NUMERIC),2) AS pow_avg, round(r.pow_last/10.0,1) AS pow_last, "
+           "round(r.bat_min/10.0,1) AS bat_min, round(r.bat_max/10.0,1) AS bat_max, "
+           "round(CAST(r.bat_avg/10.0 AS NUMERIC),2) AS bat_avg, round(r.bat_last/10.0,1) AS bat_last, "
+           "r.alarms, g.ip FROM points_rollup r LEFT JOIN gateways g ON g.id=r.gateway;";
+    sql << view + "gates_rollup_text AS SELECT r.id, r.tmr, r.period, r.num, r.samples, r.cnt_min, r.cnt_max, "
+           "round(CAST(r.cnt_avg AS NUMERIC),1) AS cnt_avg, r.cnt_last, r.alarms, g.ip "
+           "FROM gates_rollup r LEFT JOIN gateways g ON g.id=r.gateway;";
+
+    for(const QString &s:sql) if(!exec(db,s,error)) return false;
+    return true;
+}
+
+QString SQLSchema::partitionName(const QString &table, const QDate &month)
+{
+    return table + "_" + month.toString("yyyy_MM");
+}
+
+bool SQLSchema::createPartitions(QSqlDatabase &db, const QDate &from, const QDate &to, QString &error)
+{
+    for(QDate m(from.year(),from.month(),1);m<=to;m=m.addMonths(1)) {
+        QString lower = m.toString("yyyy-MM-dd");
+        QString upper = m.addMonths(1).toString("yyyy-MM-dd");
+        for(const QString &t:partitionedTables) {
+            if(!exec(db,"CREATE TABLE IF NOT EXISTS " + partitionName(t,m) + " PARTITION OF " + t +
+                     " FOR VALUES FROM ('" + lower + "') TO ('" + upper + "');",error)) return false;
+        }
+    }
+    return true;
+}
+
+bool SQLSchema::dropPartitions(QSqlDatabase &db, const QDate &before, QString &error)
+{
+    for(const QString &t:partitionedTables) {
+        QSqlQuery query(db);
+        query.prepare("SELECT c.relname FROM pg_inherits i "
+                      "JOIN pg_class c ON c.oid=i.inhrelid JOIN pg_class p ON p.oid=i.inhparent "
+                      "WHERE p.relname=?;");
+        query.addBindValue(t);
+        if(!query.exec()) {
+            error = query.lastError().text();
+            return false;
+        }
+        QStringList old;
+        while(query.next()) {
+            QString name = query.value(0).toString();
+            QDate month = QDate::fromString(name.mid(t.size()+1),"yyyy_MM");
+            // секция удаляется, только если закончилась раньше границы хранения
+            if(month.isValid() && month.addMonths(1)<=before) old << name;
+        }
+        for(const QString &name:old) if(!exec(db,"DROP TABLE IF EXISTS " + name + ";",error)) return false;
+    }
+    return true;
+}
+
+bool SQLSchema::maintain(QSqlDatabase &db, int keepMonths, QString &error)
+{
+    QDate today = QDate::currentDate();
+    QDate month(today.year(),today.month(),1);
+    // минутные агрегаты нужны для недавних интервалов, часовые и суточные хранятся со всем архивом
+    QStringList rollups;
+    rollups << "DELETE FROM points_rollup WHERE period=0 AND tmr<'" + today.addDays(-minuteRollupDays).toString("yyyy-MM-dd") + "';"
+            << "DELETE FROM gates_rollup WHERE period=0 AND tmr<'" + today.addDays(-minuteRollupDays).toString("yyyy-MM-dd") + "';";
+    if(keepMonths>0) {
+        QString before = month.addMonths(1-keepMonths).toString("yyyy-MM-dd");
+        rollups << "DELETE FROM points_rollup WHERE tmr<'" + before + "';" << "DELETE FROM gates_rollup WHERE tmr<'" + before + "';";
+    }
+    for(const QString &r:rollups) if(!exec(db,r,error)) return false;
+    if(isSQLite(db)) {
+        // секций нет - старые строки удаляются
+        if(keepMonths<=0) return true;
+        QString before = month.addMonths(1-keepMonths).toString("yyyy-MM-dd");
+        for(const QString &t:partitionedTables) {
+            if(!exec(db,"DELETE FROM " + t + " WHERE tmr<'" + before + "';",error)) return false;
+        }
+        return true;
+    }
+    if(!createPartitions(db,month,month.addMonths(monthsAhead),error)) return false;
+    if(keepMonths>0 && !dropPartitions(db,month.addMonths(1-keepMonths),error)) return false;
+    return true;
+}
+
+bool SQLSchema::migrate(QSqlDatabase &db, int from, QString &error)
+{
+    // старые таблицы переименовываются, данные переносятся в новые и удаляются
+    // представления привязаны к старым таблицам и пересоздаются вместе с новыми
+    if(!exec(db,"DROP VIEW IF EXISTS points_text;",error)) return false;
+    if(!exec(db,"DROP VIEW IF EXISTS gates_text;",error)) return false;
+    // таблицы, появившиеся в более новых версиях, переносить не нужно
+    QStringList renamed;
+    for(const QString &t:partitionedTables) {
+        if(!db.tables().contains(t)) continue;
+        renamed << t;
+        if(!exec(db,"ALTER TABLE " + t + " RENAME TO " + t + "_old;",error)) return false;
+        // индексы остаются со старыми именами и помешали бы создать такие же на новой таблице
+        QSqlQuery query(db);
+        query.prepare("SELECT indexname FROM pg_indexes WHERE tablename=? AND indexname NOT LIKE '%pkey%';");
+        query.addBindValue(t + "_old");
+        QStringList indexes;
+        if(query.exec()) while(query.next()) indexes << query.value(0).toString();
+        for(const QString &i:indexes) if(!exec(db,"DROP INDEX " + i + ";",error)) return false;
+    }
+    if(!createTables(db,error)) return false;
+
+    // секции на всё время, за которое есть данные
+    QDate first = QDate::currentDate();
+    for(const QString &t:renamed) {
+        QSqlQuery query(db);
+        if(query.exec("SELECT min(tmr) FROM " + t + "_old;") && query.next() && !query.value(0).isNull()) {
+            first = qMin(first,query.value(0).toDate());
+        }
+    }
+    if(!createPartitions(db,first,QDate::currentDate(),error)) return false;
+
+    QStringList sql;
+    if(from==1) {
+        sql << "INSERT INTO gateways (ip) SELECT ip FROM points_old UNION SELECT ip FROM gates_old ON CONFLICT (ip) DO NOTHING;";
+        sql << "INSERT INTO points (tmr, gateway, gate, num, di1, di2, do1, do2, speaker, pow, bat) "
+               "SELECT p.tmr, g.id, p.gate, p.num, " +
+               stateCodeSql("p.di1") + ", " + stateCodeSql("p.di2") + ", " +
+               stateCodeSql("p.do1") + ", " + stateCodeSql("p.do2") + ", " + stateCodeSql("p.speaker") + ", "
+               "round(p.pow*10), round(p.bat*10) "
+               "FROM points_old p JOIN gateways g ON g.ip=p.ip ORDER BY p.id;";
+        sql << "INSERT INTO gates (tmr, gateway, num, cnt, di1, di2, di3, do1, do2) "
+               "SELECT t.tmr, g.id, t.num, t.cnt, " +
+               stateCodeSql("t.di1") + ", " + stateCodeSql("t.di2") + ", " + stateCodeSql("t.di3") + ", " +
+               stateCodeSql("t.do1") + ", " + stateCodeSql("t.do2") + " "
+               "FROM gates_old t JOIN gateways g ON g.ip=t.ip ORDER BY t.id;";
+    }else {
+        sql << "INSERT INTO points (tmr, gateway, gate, num, di1, di2, do1, do2, speaker, pow, bat) "
+               "SELECT tmr, gateway, gate, num, di1, di2, do1, do2, speaker, pow, bat FROM points_old ORDER BY id;";
+        sql << "INSERT INTO gates (tmr, gateway, num, cnt, di1, di2, di3, do1, do2) "
+               "SELECT tmr, gateway, num, cnt, di1, di2, di3, do1, do2 FROM gates_old ORDER BY id;";
+    }
+    sql << "INSERT INTO point_alarms (alarm, type, point, gate, ip, tmr) "
+           "SELECT alarm, type, point, gate, ip, tmr FROM point_alarms_old ORDER BY id;";
+    sql << "INSERT INTO gate_alarms (alarm, type, gate, ip, tmr) "
+           "SELECT alarm, type, gate, ip, tmr FROM gate_alarms_old ORDER BY id;";
+    sql << "INSERT INTO journal (message, type, tmr) SELECT message, type, tmr FROM journal_old ORDER BY id;";
+    for(const QString &t:renamed) sql << "DROP TABLE " + t + "_old;";
+    for(const QString &s:sql) if(!exec(db,s,error)) return false;
+    return true;
+}
+
+bool SQLSchema::update(QSqlDatabase &db, QString &error)
+{
+    if(!exec(db,"CREATE TABLE IF NOT EXISTS schema_version (version INTEGER NOT NULL);",error)) return false;
+    int current = currentVersion(db);
+    if(current>version) {
+        error = "версия базы данных " + QString::number(current) + " новее программы";
+        return false;
+    }
+    // перевод выполняется целиком или не выполняется вовсе
+    db.transaction();
+    // база SQLite создаётся сразу в последней версии, переводить нечего
+    // начиная с версии с секциями таблицы только добавляются
+    bool ok = current>0 && current<partitionedVersion && !isSQLite(db) ? migrate(db,current,error) : createTables(db,error);
+    // до версии 7 срез тревог не хранил условие
+    if(ok && !db.record("alarm_snapshots").contains("condition")) {
+        ok = exec(db,"ALTER TABLE alarm_snapshots ADD COLUMN condition smallint;",error);
+    }
+    if(ok && current!=version) {
+        ok = exec(db,"DELETE FROM schema_version;",error) &&
+             exec(db,"INSERT INTO schema_version (version) VALUES (" + QString::number(version) + ");",error);
+    }
+    if(ok) ok = db.commit();
+    else db.rollback();
+    return ok;
+}
@@ -0,0 +1,41 @@
+#ifndef SQLSCHEMA_H
+#define SQLSCHEMA_H
+
+#include <QString>
+#include <QStringList>
+#include <QSqlDatabase>
+#include <QDate>
+
+// схема базы архива: создание таблиц, индексов и перевод старых версий
+// состояния входов, выходов и динамиков хранятся кодами, текст отдают представления *_text
+// журналы разбиты на помесячные секции по tmr, старые секции удаляются целиком
+class SQLSchema
+{
+public:
+    static const int version = 7;
+    static const int monthsAhead = 2;     // секции создаются заранее на текущий и следующие месяцы
+    static const int minuteRollupDays = 31;
+
+    static qint16 stateCode(const QString &name);
+    static QString stateNameSql(const QString &column);
+    static bool update(QSqlDatabase &db, QString &error);
+    // создание секций вперёд и удаление секций старше keepMonths месяцев (0 - хранить всё)
+    static bool maintain(QSqlDatabase &db, int keepMonths, QString &error);
+
+private:
+    static const QStringList stateNames;
+    static const int partitionedVersion = 3;
+    static const QStringList partitionedTables;
+    static QString stateCodeSql(const QString &column);
+    static bool isSQLite(const QSqlDatabase &db);
+    static int currentVersion(QSqlDatabase &db);
+    static bool exec(QSqlDatabase &db, const QString &sql, QString &error);
+    static bool createTables(QSqlDatabase &db, QString &error);
+    static bool migrate(QSqlDatabase &db, int from, QString &error);
+    static QString partitionName(const QString &table, const QDate &month);
+    static bool createPartitions(QSqlDatabase &db, const QDate &from, const QDate &to, QString &error);
+    static bool dropPartitions(QSqlDatabase &db, const QDate &before, QString &error);
+    SQLSchema();
+};
+
+#endif // SQLSCHEMA_H
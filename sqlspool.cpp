@@ -0,0 +1,164 @@
+#include "sqlspool.h"
+#include "checksum.h"
+#include <QCoreApplication>
+#include <QDataStream>
+#include <cstring>
+#include <algorithm>
+
+SQLSpool::SQLSpool(const QString &dirName) : dir(dirName)
+{
+    dir.mkpath(".");
+    // сегменты прошлого запуска переносятся в базу в порядке номеров
+    QStringList names = dir.entryList(QStringList() << "segment_*.bin",QDir::Files,QDir::Name);
+    for(const QString &name:names) {
+        nextIndex = std::max(nextIndex,name.mid(8,8).toInt()+1);
+        std::unique_ptr<Segment> s = openSegment(dir.filePath(name),0);
+        if(!s) continue;
+        if(s->header->readPos>=s->header->writePos) closeSegment(*s,true);
+        else segments.push_back(std::move(s));
+    }
+}
+
+SQLSpool::~SQLSpool()
+{
+    for(auto &s:segments) closeSegment(*s,false);
+}
+
+QString SQLSpool::defaultDirName()
+{
+    return QCoreApplication::applicationDirPath()+"/spool";
+}
+
+std::unique_ptr<SQLSpool::Segment> SQLSpool::openSegment(const QString &fileName, quint64 size)
+{
+    // size==0 - открыть существующий сегмент, иначе создать новый
+    std::unique_ptr<Segment> s = std::make_unique<Segment>();
+    s->file.setFileName(fileName);
+    if(!s->file.open(QIODevice::ReadWrite)) return nullptr;
+    if(size) {
+        if(!s->file.resize(static_cast<qint64>(size))) {s->file.close();s->file.remove();return nullptr;}
+    }else size = static_cast<quint64>(s->file.size());
+    if(size<=headerSize) {s->file.close();return nullptr;}
+    s->map = s->file.map(0,static_cast<qint64>(size));
+    if(!s->map) {s->file.close();return nullptr;}
+    s->header = reinterpret_cast<SegmentHeader*>(s->map);
+    if(s->file.size()==static_cast<qint64>(size) && s->header->magic!=segmentMagic) {
+        std::memset(s->map,0,headerSize);
+        s->header->magic = segmentMagic;
+        s->header->version = 1;
+        s->header->size = size;
+        s->header->readPos = headerSize;
+        s->header->writePos = headerSize;
+    }
+    if(s->header->size!=size || s->header->writePos>size || s->header->readPos>s->header->writePos) {
+        s->file.unmap(s->map);
+        s->file.close();
+        return nullptr;
+    }
+    s->cursor = s->header->readPos;
+    return s;
+}
+
+void SQLSpool::closeSegment(Segment &s, bool remove)
+{
+    if(s.map) s.file.unmap(s.map);
+    s.map = nullptr;
+    s.header = nullptr;
+    s.file.close();
+    if(remove) s.file.remove();
+}
+
+bool SQLSpool::isEmpty() const
+{
+    return std::all_of(segments.begin(),segments.end(),[](const std::unique_ptr<Segment> &s){
+        return s->header->readPos>=s->header->writePos;
+    });
+}
+
+quint64 SQLSpool::pendingBytes() const
+{
+    quint64 bytes = 0;
+    for(const auto &s:segments) bytes += s->header->writePos-s->header->readPos;
+    return bytes;
+}
+
+bool SQLSpool::append(int table, const QVariantList &values)
+{
+    QByteArray payload;
+    QDataStream out(&payload,QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_12);
+    out << qint32(table) << values;
+    quint64 total = (8+static_cast<quint64>(payload.size())+7) & ~quint64(7);
+
+    if(segments.empty() || segments.back()->header->writePos+total>segments.back()->header->size) {
+        quint64 size = std::max(static_cast<quint64>(segmentSize),headerSize+total);
+        std::unique_ptr<Segment> s = openSegment(dir.filePath(QString("segment_%1.bin").arg(nextIndex++,8,10,QChar('0'))),size);
+        if(!s) return false;
+        segments.push_back(std::move(s));
+    }
+    Segment &s = *segments.back();
+    uchar *p = s.map+s.header->writePos;
+    quint32 length = static_cast<quint32>(payload.size());
+    quint32 crc = static_cast<quint32>(CheckSum::getCRC16(payload));
+    std::memcpy(p,&length,4);
+    std::memcpy(p+4,&crc,4);
+    std::memcpy(p+8,payload.constData(),static_cast<size_t>(payload.size()));
+    // позиция записи сдвигается последней: недописанная пачка после сбоя не читается
+    s.header->writePos += total;
+    return true;
+}
+
+bool SQLSpool::next(int &table, QVariantList &values)
+{
+    while(readSegment<segments.size()) {
+        Segment &s = *segments[readSegment];
+        if(s.cursor+8<=s.header->writePos) {
+            quint32 length, crc;
+            std::memcpy(&length,s.map+s.cursor,4);
+            std::memcpy(&crc,s.map+s.cursor+4,4);
+            quint64 total = (8+static_cast<quint64>(length)+7) & ~quint64(7);
+            if(s.cursor+total<=s.header->writePos) {
+                QByteArray payload(reinterpret_cast<const char*>(s.map+s.cursor+8),static_cast<int>(length));
+                s.cursor += total;
+                if(static_cast<quint32>(CheckSum::getCRC16(payload))!=crc) continue;
+                QDataStream in(payload);
+                in.setVersion(QDataStream::Qt_5_12);
+                qint32 t;
+                in >> t >> values;
+                if(in.status()!=QDataStream::Ok) continue;
+                table = t;
+                return true;
+            }
+            // повреждённый конец сегмента пропускается
+            s.cursor = s.header->writePos;
+        }
+        if(readSegment+1==segments.size()) break;
+        readSegment++;
+    }
+    return false;
+}
+
+void SQLSpool::commit()
+{
+    // полностью прочитанные сегменты удаляются, в текущем сохраняется позиция чтения
+    while(readSegment>0) {
+        closeSegment(*segments.front(),true);
+        segments.pop_front();
+        readSegment--;
+    }
+    if(segments.empty()) return;
+    Segment &s = *segments.front();
+    s.header->readPos = s.cursor;
+    if(s.header->readPos>=s.header->writePos) {
+        // последний сегмент используется заново с начала
+        s.header->readPos = headerSize;
+        s.header->writePos = headerSize;
+        s.cursor = headerSize;
+    }
+}
+
+void SQLSpool::rewind()
+{
+    for(size_t i=0;i<=readSegment && i<segments.size();i++) segments[i]->cursor = segments[i]->header->readPos;
+    readSegment = 0;
+}
@@ -0,0 +1,61 @@
+#ifndef SQLSPOOL_H
+#define SQLSPOOL_H
+
+#include <QFile>
+#include <QDir>
+#include <QVariantList>
+#include <deque>
+#include <memory>
+
+// локальный журнал строк, которые не удалось записать в базу
+// пачки строк дописываются в файлы-сегменты, отображённые в память, и переживают перезапуск программы
+// после восстановления соединения пачки читаются по порядку и удаляются только после фиксации транзакции
+class SQLSpool
+{
+public:
+    static const qint64 segmentSize = 8*1024*1024;
+
+    explicit SQLSpool(const QString &dirName);
+    ~SQLSpool();
+    bool isEmpty() const;
+    quint64 pendingBytes() const;
+    bool append(int table, const QVariantList &values);
+    // чтение следующей пачки, прочитанное удаляется вызовом commit(), rewind() возвращает к началу
+    bool next(int &table, QVariantList &values);
+    void commit();
+    void rewind();
+
+    static QString defaultDirName();
+
+private:
+    struct SegmentHeader {
+        quint32 magic;
+        quint32 version;
+        quint64 size;
+        quint64 readPos;        // начало непрочитанных пачек
+        quint64 writePos;       // конец последней записанной пачки
+    };
+
+    struct Segment {
+        QFile file;
+        uchar *map = nullptr;
+        SegmentHeader *header = nullptr;
+        quint64 cursor = 0;
+    };
+
+    static const quint32 segmentMagic = 0x53504F4C;    // "SPOL"
+    static const int headerSize = 64;
+
+    QDir dir;
+    std::deque<std::unique_ptr<Segment>> segments;
+    size_t readSegment = 0;
+    int nextIndex = 0;
+
+    std::unique_ptr<Segment> openSegment(const QString &fileName, quint64 size);
+    static void closeSegment(Segment &s, bool remove);
+
+    SQLSpool(const SQLSpool&) = delete;
+    SQLSpool& operator=(const SQLSpool&) = delete;
+};
+
+#endif // SQLSPOOL_H
@@ -0,0 +1,327 @@
+#include "statemodel.h"
+#include <QColor>
+#include <array>
+
+namespace {
+
+const char *unknownText = "не известно";
+
+const char *pointLabels[] = {"Динамики","Вход 1 (КТВ)","Вход 2","Тип входа","Выход 1 (разреш)","Выход 2 (предстарт)",
+                             "Питание, В","Аккумулятор, В","Версия","Громкость","Концевик","Фильтр входа 1, с","Фильтр входа 2, с"};
+const char *groupLabels[] = {"Число подкл. точек","Вход 1 (разреш. с предыд.)","Вход 2 (предпуск.)","Вход 3 (подтвержд. запуска)",
+                             "Выход 1 (сигнал)","Выход 2 (готовность)"};
+
+QString inputText(Input value)
+{
+    switch(value) {
+        case Input::ON:return "ВКЛ";
+        case Input::OFF:return "ВЫКЛ";
+        case Input::BREAK:return "ОБРЫВ!";
+        case Input::SHORT:return "КЗ";
+        case Input::UNUSED:return "Отключен";
+    }
+    return QString();
+}
+
+QString versionText(quint8 value)
+{
+    if(value<=200) return QString::number(value)+".0";
+    return "Загрузчик " + QString::number(value-200)+".0";
+}
+
+QString volumeText(quint8 value)
+{
+    if(value==0) return "максимум";
+    if(value>3) return "некорректное значение" + QString::number(value);
+    return "1/"+QString::number(1<<value);
+}
+
+// строки для всех значений кода строятся один раз
+template<QString (*text)(quint8)> const QString &codeText(quint8 value)
+{
+    static const std::array<QString,256> texts = []{
+        std::array<QString,256> t;
+        for(int i=0;i<256;i++) t[static_cast<std::size_t>(i)] = text(static_cast<quint8>(i));
+        return t;
+    }();
+    return texts[value];
+}
+
+QVariant inputColor(Input value)
+{
+    if(value==Input::ON) return QColor(Qt::black);
+    if(value==Input::UNUSED) return QColor(Qt::darkGray);
+    return QColor(Qt::red);
+}
+
+}
+
+StateModel::StateModel(QObject *parent) : QAbstractItemModel(parent)
+{
+    pointOffset.push_back(0);
+}
+
+void StateModel::setGates(const std::vector<GateState> &gates)
+{
+    beginResetModel();
+    std::size_t groupCnt = gates.size();
+    groupNames.clear();
+    pointOffset.assign(1,0);
+    pointNames.clear();
+    pointPrefixes.clear();
+    pointGroup.clear();
+    for(std::size_t i=0;i<groupCnt;i++) {
+        groupNames.push_back(gates[i].name);
+        for(const QString &name:gates[i].points) {
+            pointNames.push_back(name);
+            pointPrefixes.push_back(gates[i].name + " " + name + ": ");
+            pointGroup.push_back(static_cast<int>(i));
+        }
+        pointOffset.push_back(static_cast<int>(pointNames.size()));
+    }
+    std::size_t pointCnt = pointNames.size();
+    notActual.assign(groupCnt,false);
+    groupKnown.assign(groupCnt,0);
+    groupDirty.assign(groupCnt,0);
+    dirtyGroups.clear();
+    std::apply([groupCnt](auto &...column){(column.assign(groupCnt,{}),...);},groups);
+    std::get<static_cast<std::size_t>(GroupField::DI1)>(groups).assign(groupCnt,Input::OFF);
+    std::get<static_cast<std::size_t>(GroupField::DI2)>(groups).assign(groupCnt,Input::OFF);
+    std::get<static_cast<std::size_t>(GroupField::DI3)>(groups).assign(groupCnt,Input::OFF);
+
+    pointKnown.assign(pointCnt,0);
+    pointDirty.assign(pointCnt,0);
+    dirtyPoints.clear();
+    std::apply([pointCnt](auto &...column){(column.assign(pointCnt,{}),...);},points);
+    std::get<static_cast<std::size_t>(PointField::SPEAKER)>(points).assign(pointCnt,Speaker::NOT_CHECKED);
+    std::get<static_cast<std::size_t>(PointField::DI1)>(points).assign(pointCnt,Input::OFF);
+    std::get<static_cast<std::size_t>(PointField::DI2)>(points).assign(pointCnt,Input::OFF);
+    endResetModel();
+}
+
+int StateModel::pointCount(int group) const
+{
+    if(group<0 || group>=groupCount()) return 0;
+    return pointOffset[static_cast<std::size_t>(group)+1]-pointOffset[static_cast<std::size_t>(group)];
+}
+
+int StateModel::pointIndex(int group, int point) const
+{
+    if(point<0 || point>=pointCount(group)) return -1;
+    return pointOffset[static_cast<std::size_t>(group)]+point;
+}
+
+QString StateModel::groupName(int group) const
+{
+    if(group<0 || group>=groupCount()) return QString();
+    return groupNames[static_cast<std::size_t>(group)];
+}
+
+QString StateModel::pointName(int group, int point) const
+{
+    int i = pointIndex(group,point);
+    if(i<0) return QString();
+    return pointNames[static_cast<std::size_t>(i)];
+}
+
+QString StateModel::alarmPrefix(int group, int point) const
+{
+    int i = pointIndex(group,point);
+    if(i<0) return QString();
+    return pointPrefixes[static_cast<std::size_t>(i)];
+}
+
+QString StateModel::pointText(int group, int point, PointField field) const
+{
+    int i = pointIndex(group,point);
+    if(i<0) return QString();
+    return pointFieldData(i,static_cast<int>(field),Qt::DisplayRole).toString();
+}
+
+const QString &StateModel::inp2TypeText(Inp2Type type)
+{
+    static const std::array<QString,4> texts = {"КСЛ","ЗАШТЫБОВКА","ПЕРЕЕЗД","ОГРАЖДЕНИЕ"};
+    return texts[static_cast<std::size_t>(type)];
+}
+
+void StateModel::markGroup(int group, quint8 fields)
+{
+    quint8 &dirty = groupDirty[static_cast<std::size_t>(group)];
+    if(!dirty) dirtyGroups.push_back(group);
+    dirty |= fields;
+}
+
+void StateModel::markPoint(int index, quint16 fields)
+{
+    quint16 &dirty = pointDirty[static_cast<std::size_t>(index)];
+    if(!dirty) dirtyPoints.push_back(index);
+    dirty |= fields;
+}
+
+void StateModel::setNotActual(int group, bool value)
+{
+    if(group<0 || group>=groupCount() || notActual[static_cast<std::size_t>(group)]==value) return;
+    notActual[static_cast<std::size_t>(group)] = value;
+    markGroup(group,quint8((1<<groupFieldCnt)-1));
+}
+
+void StateModel::setPointToDefault(int group, int point)
+{
+    int i = pointIndex(group,point);
+    if(i<0 || !pointKnown[static_cast<std::size_t>(i)]) return;
+    pointKnown[static_cast<std::size_t>(i)] = 0;
+    markPoint(i,quint16((1<<pointFieldCnt)-1));
+}
+
+void StateModel::flush()
+{
+    // диапазон строк от первого до последнего изменённого поля
+    auto range = [](unsigned bits, int &first, int &last) {
+        first = 0;
+        while(!(bits & (1u<<first))) first++;
+        last = first;
+        while(bits>>(last+1)) last++;
+    };
+    int first, last;
+    for(int g:dirtyGroups) {
+        quint8 &dirty = groupDirty[static_cast<std::size_t>(g)];
+        range(dirty,first,last);
+        updatedCells += static_cast<quint64>(qPopulationCount(dirty));
+        dirty = 0;
+        QModelIndex parent = index(g,0);
+        emit dataChanged(index(first,1,parent),index(last,1,parent));
+    }
+    dirtyGroups.clear();
+    for(int i:dirtyPoints) {
+        quint16 &dirty = pointDirty[static_cast<std::size_t>(i)];
+        range(dirty,first,last);
+        updatedCells += static_cast<quint64>(qPopulationCount(dirty));
+        dirty = 0;
+        int g = pointGroup[static_cast<std::size_t>(i)];
+        QModelIndex parent = index(groupFieldCnt+i-pointOffset[static_cast<std::size_t>(g)],0,index(g,0));
+        emit dataChanged(index(first,1,parent),index(last,1,parent));
+    }
+    dirtyPoints.clear();
+}
+
+QModelIndex StateModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if(!hasIndex(row,column,parent)) return QModelIndex();
+    if(!parent.isValid()) return createIndex(row,column,quintptr(0));
+    // строки внутри группы хранят номер группы, строки полей точки - номер точки
+    if(parent.internalId()==0) return createIndex(row,column,static_cast<quintptr>(parent.row())+1);
+    int g = static_cast<int>(parent.internalId())-1;
+    return createIndex(row,column,pointParent | static_cast<quintptr>(pointOffset[static_cast<std::size_t>(g)]+parent.row()-groupFieldCnt));
+}
+
+QModelIndex StateModel::parent(const QModelIndex &child) const
+{
+    if(!child.isValid() || child.internalId()==0) return QModelIndex();
+    if(child.internalId() & pointParent) {
+        int i = static_cast<int>(child.internalId() & ~pointParent);
+        int g = pointGroup[static_cast<std::size_t>(i)];
+        return createIndex(groupFieldCnt+i-pointOffset[static_cast<std::size_t>(g)],0,static_cast<quintptr>(g)+1);
+    }
+    return createIndex(static_cast<int>(child.internalId())-1,0,quintptr(0));
+}
+
+int StateModel::rowCount(const QModelIndex &parent) const
+{
+    if(!parent.isValid()) return groupCount();
+    if(parent.column()!=0 || (parent.internalId() & pointParent)) return 0;
+    if(parent.internalId()==0) return groupFieldCnt+pointCount(parent.row());
+    return parent.row()>=groupFieldCnt ? pointFieldCnt : 0;
+}
+
+int StateModel::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent)
+    return 2;
+}
+
+QVariant StateModel::groupFieldData(int group, int field, int role) const
+{
+    std::size_t g = static_cast<std::size_t>(group);
+    if(role==Qt::DisplayRole) {
+        if(notActual[g]) return "нет данных";
+        if(!(groupKnown[g] & (1<<field))) return unknownText;
+        switch(static_cast<GroupField>(field)) {
+            case GroupField::POINT_CNT:return QString::number(std::get<static_cast<std::size_t>(GroupField::POINT_CNT)>(groups)[g]);
+            case GroupField::DI1:return inputText(std::get<static_cast<std::size_t>(GroupField::DI1)>(groups)[g]);
+            case GroupField::DI2:return inputText(std::get<static_cast<std::size_t>(GroupField::DI2)>(groups)[g]);
+            case GroupField::DI3:return inputText(std::get<static_cast<std::size_t>(GroupField::DI3)>(groups)[g]);
+            case GroupField::DO1:return std::get<static_cast<std::size_t>(GroupField::DO1)>(groups)[g] ? "Вкл" : "Выкл";
+            case GroupField::DO2:return std::get<static_cast<std::size_t>(GroupField::DO2)>(groups)[g] ? "Вкл" : "Выкл";
+            case GroupField::COUNT:break;
+        }
+    }
+    return QVariant();
+}
+
+QVariant StateModel::pointFieldData(int index, int field, int role) const
+{
+    std::size_t i = static_cast<std::size_t>(index);
+    bool known = pointKnown[i] & (1<<field);
+    PointField f = static_cast<PointField>(field);
+    if(role==Qt::DisplayRole) {
+        if(!known) return unknownText;
+        switch(f) {
+            case PointField::SPEAKER:
+                switch(std::get<static_cast<std::size_t>(PointField::SPEAKER)>(points)[i]) {
+                    case Speaker::CORRECT:return "Исправны";
+                    case Speaker::PROBLEM:return "Авария";
+                    case Speaker::NOT_CHECKED:return "Не проверялись";
+                }
+                break;
+            case PointField::DI1:return inputText(std::get<static_cast<std::size_t>(PointField::DI1)>(points)[i]);
+            case PointField::DI2:return inputText(std::get<static_cast<std::size_t>(PointField::DI2)>(points)[i]);
+            case PointField::DI2_TYPE:return inp2TypeText(std::get<static_cast<std::size_t>(PointField::DI2_TYPE)>(points)[i]);
+            case PointField::DO1:return std::get<static_cast<std::size_t>(PointField::DO1)>(points)[i] ? "Вкл" : "Выкл";
+            case PointField::DO2:return std::get<static_cast<std::size_t>(PointField::DO2)>(points)[i] ? "Вкл" : "Выкл";
+            case PointField::POWER:return QString::number(std::get<static_cast<std::size_t>(PointField::POWER)>(points)[i]);
+            case PointField::BATTERY:return QString::number(std::get<static_cast<std::size_t>(PointField::BATTERY)>(points)[i]);
+            case PointField::VERSION:return codeText<versionText>(std::get<static_cast<std::size_t>(PointField::VERSION)>(points)[i]);
+            case PointField::VOLUME:return codeText<volumeText>(std::get<static_cast<std::size_t>(PointField::VOLUME)>(points)[i]);
+            case PointField::LIMIT_SWITCH:return std::get<static_cast<std::size_t>(PointField::LIMIT_SWITCH)>(points)[i] ? "Вкл" : "Выкл";
+            case PointField::DI1_FILTER:return QString::number(std::get<static_cast<std::size_t>(PointField::DI1_FILTER)>(points)[i]);
+            case PointField::DI2_FILTER:return QString::number(std::get<static_cast<std::size_t>(PointField::DI2_FILTER)>(points)[i]);
+            case PointField::COUNT:break;
+        }
+    }else if(role==Qt::ForegroundRole && known) {
+        if(f==PointField::SPEAKER) {
+            if(std::get<static_cast<std::size_t>(PointField::SPEAKER)>(points)[i]==Speaker::CORRECT) return QColor(Qt::black);
+            return QColor(Qt::red);
+        }
+        if(f==PointField::DI1) return inputColor(std::get<static_cast<std::size_t>(PointField::DI1)>(points)[i]);
+        if(f==PointField::DI2) return inputColor(std::get<static_cast<std::size_t>(PointField::DI2)>(points)[i]);
+    }
+    return QVariant();
+}
+
+QVariant StateModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid()) return QVariant();
+    quintptr id = index.internalId();
+    if(id==0) {
+        if(index.column()==0 && role==Qt::DisplayRole) return groupNames[static_cast<std::size_t>(index.row())];
+        return QVariant();
+    }
+    if(id & pointParent) {
+        int i = static_cast<int>(id & ~pointParent);
+        if(index.column()==0) return role==Qt::DisplayRole ? QVariant(pointLabels[index.row()]) : QVariant();
+        return pointFieldData(i,index.row(),role);
+    }
+    int g = static_cast<int>(id)-1;
+    if(index.row()>=groupFieldCnt) {
+        if(index.column()==0 && role==Qt::DisplayRole) return pointNames[static_cast<std::size_t>(pointOffset[static_cast<std::size_t>(g)]+index.row()-groupFieldCnt)];
+        return QVariant();
+    }
+    if(index.column()==0) return role==Qt::DisplayRole ? QVariant(groupLabels[index.row()]) : QVariant();
+    return groupFieldData(g,index.row(),role);
+}
+
+QVariant StateModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if(orientation!=Qt::Horizontal || role!=Qt::DisplayRole) return QVariant();
+    return section==0 ? "Имя" : "Состояние";
+}
@@ -0,0 +1,117 @@
+#ifndef STATEMODEL_H
+#define STATEMODEL_H
+
+#include <QAbstractItemModel>
+#include <QString>
+#include <tuple>
+#include <vector>
+#include "enums.h"
+#include "projectconfig.h"
+
+// поля в порядке строк дерева
+enum class PointField {SPEAKER,DI1,DI2,DI2_TYPE,DO1,DO2,POWER,BATTERY,VERSION,VOLUME,LIMIT_SWITCH,DI1_FILTER,DI2_FILTER,COUNT};
+enum class GroupField {POINT_CNT,DI1,DI2,DI3,DO1,DO2,COUNT};
+
+// состояние групп и точек: столбец на каждое поле, точки всех групп подряд
+// дерево: группа -> строки полей группы, затем точки -> строки полей точки
+class StateModel : public QAbstractItemModel
+{
+    Q_OBJECT
+
+    // версия и громкость хранятся кодами точки, текст берётся из заранее построенных таблиц
+    using PointColumns = std::tuple<std::vector<Speaker>,std::vector<Input>,std::vector<Input>,std::vector<Inp2Type>,
+        std::vector<bool>,std::vector<bool>,std::vector<double>,std::vector<double>,std::vector<quint8>,std::vector<quint8>,
+        std::vector<bool>,std::vector<double>,std::vector<double>>;
+    using GroupColumns = std::tuple<std::vector<int>,std::vector<Input>,std::vector<Input>,std::vector<Input>,
+        std::vector<bool>,std::vector<bool>>;
+
+    static const int pointFieldCnt = static_cast<int>(PointField::COUNT);
+    static const int groupFieldCnt = static_cast<int>(GroupField::COUNT);
+    static const quintptr pointParent = quintptr(1)<<31;   // internalId строк полей точки
+
+    std::vector<QString> groupNames;
+    std::vector<bool> notActual;
+    std::vector<quint8> groupKnown;     // биты полученных полей, остальные "не известно"
+    std::vector<int> pointOffset;       // первая точка группы, последний элемент - число точек
+    GroupColumns groups;
+
+    std::vector<QString> pointNames;
+    std::vector<QString> pointPrefixes;
+    std::vector<int> pointGroup;
+    std::vector<quint16> pointKnown;
+    PointColumns points;
+
+    // изменённые поля копятся до flush и уходят одним dataChanged на группу или точку
+    std::vector<quint8> groupDirty;
+    std::vector<quint16> pointDirty;
+    std::vector<int> dirtyGroups;
+    std::vector<int> dirtyPoints;
+    quint64 updatedCells = 0;
+
+    int pointIndex(int group, int point) const;
+    void markGroup(int group, quint8 fields);
+    void markPoint(int index, quint16 fields);
+    QVariant groupFieldData(int group, int field, int role) const;
+    QVariant pointFieldData(int index, int field, int role) const;
+
+public:
+    template<PointField F> using PointType = typename std::tuple_element<static_cast<std::size_t>(F),PointColumns>::type::value_type;
+    template<GroupField F> using GroupType = typename std::tuple_element<static_cast<std::size_t>(F),GroupColumns>::type::value_type;
+
+    explicit StateModel(QObject *parent = nullptr);
+    void setGates(const std::vector<GateState> &gates);
+
+    int groupCount() const {return static_cast<int>(groupNames.size());}
+    int pointCount(int group) const;        // точек группы по конфигурации
+    QString groupName(int group) const;
+    QString pointName(int group, int point) const;
+    QString alarmPrefix(int group, int point) const;    // "группа точка: "
+    QString pointText(int group, int point, PointField field) const;
+    quint64 getUpdatedCells() const {return updatedCells;}
+    static const QString &inp2TypeText(Inp2Type type);
+
+    // поля точек сверх реального числа точек группы не записываются
+    // в дерево уходят только поля, значение которых изменилось
+    template<PointField F> void setPoint(int group, int point, const PointType<F> &value) {
+        int i = pointIndex(group,point);
+        if(i<0 || point>=groupValue<GroupField::POINT_CNT>(group)) return;
+        std::size_t n = static_cast<std::size_t>(i);
+        quint16 bit = quint16(1)<<static_cast<int>(F);
+        auto &&cell = std::get<static_cast<std::size_t>(F)>(points)[n];
+        if((pointKnown[n] & bit) && cell==value) return;
+        cell = value;
+        pointKnown[n] |= bit;
+        markPoint(i,bit);
+    }
+    template<PointField F> PointType<F> pointValue(int group, int point) const {
+        int i = pointIndex(group,point);
+        if(i<0) return PointType<F>();
+        return std::get<static_cast<std::size_t>(F)>(points)[static_cast<std::size_t>(i)];
+    }
+    template<GroupField F> void setGroup(int group, const GroupType<F> &value) {
+        if(group<0 || group>=groupCount()) return;
+        std::size_t n = static_cast<std::size_t>(group);
+        quint8 bit = quint8(1)<<static_cast<int>(F);
+        auto &&cell = std::get<static_cast<std::size_t>(F)>(groups)[n];
+        if((groupKnown[n] & bit) && cell==value) return;
+        cell = value;
+        groupKnown[n] |= bit;
+        markGroup(group,bit);
+    }
+    template<GroupField F> GroupType<F> groupValue(int group) const {
+        if(group<0 || group>=groupCount()) return GroupType<F>();
+        return std::get<static_cast<std::size_t>(F)>(groups)[static_cast<std::size_t>(group)];
+    }
+    void setNotActual(int group, bool value);
+    void setPointToDefault(int group, int point);
+    void flush();
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+};
+
+#endif // STATEMODEL_H
@@ -0,0 +1,172 @@
+#include "transcodepool.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+
+TranscodePool::TranscodePool(QObject *parent) : QObject(parent)
+{
+    QDir dir(QCoreApplication::applicationDirPath());
+    program = dir.absolutePath()+"/utils/ffmpeg.exe";
+    dir.mkpath("audio_records");
+    queueFile = dir.absolutePath()+"/audio_records/transcode_queue.json";
+    // одно ядро оставляем диспетчеру
+    maxRunning = std::max(1,QThread::idealThreadCount()-1);
+    loadQueue();
+    // запуск после того, как владелец подключится к сигналам
+    QTimer::singleShot(0,this,[this](){schedule();});
+}
+
+TranscodePool::~TranscodePool()
+{
+    // незавершённые задания остаются в файле очереди и будут выполнены при следующем запуске
+    for(auto it=running.begin();it!=running.end();++it) {
+        it.key()->disconnect(this);
+        it.key()->kill();
+        it.key()->waitForFinished(1000);
+        delete it.key();
+    }
+    running.clear();
+}
+
+quint64 TranscodePool::enqueue(TranscodeJob job)
+{
+    job.id = nextId++;
+    queue.append(job);
+    saveQueue();
+    schedule();
+    return job.id;
+}
+
+quint64 TranscodePool::exportRecord(const QString &source, const QString &format)
+{
+    QFileInfo info(source);
+    TranscodeJob job;
+    job.source = source;
+    job.target = info.absolutePath()+"/"+info.completeBaseName()+"."+format;
+    while(QFile::exists(job.target)) {
+        job.target.remove("."+format);
+        job.target+="_again."+format;
+    }
+    job.inputArguments << "-loglevel" << "fatal";
+    job.removeSource = false;
+    job.tag = "export";
+    return enqueue(job);
+}
+
+void TranscodePool::schedule()
+{
+    while(running.size()<maxRunning && !queue.isEmpty()) {
+        startJob(queue.takeFirst());
+    }
+}
+
+void TranscodePool::startJob(const TranscodeJob &job)
+{
+    Running r;
+    r.job = job;
+    r.job.attempts++;
+    r.process = new QProcess(this);
+    r.process->setProgram(program);
+    // "-y": результат прерванной попытки перезаписывается
+    r.process->setArguments(QStringList() << "-y" << r.job.inputArguments << "-i" << r.job.source << r.job.arguments << r.job.target);
+
+    QProcess *process = r.process;
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, [this,process](int exitCode, QProcess::ExitStatus status){
+        processFinished(process, status==QProcess::NormalExit && exitCode==0);
+    });
+    connect(process, &QProcess::errorOccurred, this, [this,process](QProcess::ProcessError error){
+        if(error==QProcess::FailedToStart) processFinished(process,false);
+    });
+    // таймаут относится только к своему процессу
+    QTimer::singleShot(jobTimeoutMs, process, [process](){
+        if(process->state()!=QProcess::NotRunning) process->kill();
+    });
+    running.insert(process,r);
+    process->start();
+}
+
+void TranscodePool::processFinished(QProcess *process, bool ok)
+{
+    auto it = running.find(process);
+    if(it==running.end()) return;
+    TranscodeJob job = it->job;
+    running.erase(it);
+    process->deleteLater();
+
+    if(ok && QFileInfo(job.target).size()>0) {
+        if(job.removeSource && QFile::exists(job.source)) QFile::remove(job.source);
+        finishedCnt++;
+        emit jobFinished(job,true);
+    }else {
+        if(QFile::exists(job.target)) QFile::remove(job.target);
+        // исходный файл сохраняется, задание повторяется
+        if(job.attempts<maxAttempts && QFile::exists(job.source)) queue.append(job);
+        else {
+            failedCnt++;
+            emit jobFinished(job,false);
+        }
+    }
+    saveQueue();
+    schedule();
+}
+
+QJsonObject TranscodePool::toJson(const TranscodeJob &job)
+{
+    QJsonObject ob;
+    ob["source"] = job.source;
+    ob["target"] = job.target;
+    ob["input arguments"] = QJsonArray::fromStringList(job.inputArguments);
+    ob["arguments"] = QJsonArray::fromStringList(job.arguments);
+    ob["remove source"] = job.removeSource;
+    ob["attempts"] = job.attempts;
+    ob["tag"] = job.tag;
+    ob["meta"] = job.meta;
+    return ob;
+}
+
+TranscodeJob TranscodePool::fromJson(const QJsonObject &ob)
+{
+    TranscodeJob job;
+    job.source = ob["source"].toString();
+    job.target = ob["target"].toString();
+    for(const QJsonValue &v:ob["input arguments"].toArray()) job.inputArguments.append(v.toString());
+    for(const QJsonValue &v:ob["arguments"].toArray()) job.arguments.append(v.toString());
+    job.removeSource = ob["remove source"].toBool(true);
+    job.attempts = ob["attempts"].toInt();
+    job.tag = ob["tag"].toString();
+    job.meta = ob["meta"].toObject();
+    return job;
+}
+
+void TranscodePool::saveQueue()
+{
+    QJsonArray jobs;
+    for(const Running &r:running) jobs.append(toJson(r.job));
+    for(const TranscodeJob &job:queue) jobs.append(toJson(job));
+    QSaveFile file(queueFile);
+    if(file.open(QIODevice::WriteOnly)) {
+        file.write(QJsonDocument(jobs).toJson());
+        file.commit();
+    }
+}
+
+void TranscodePool::loadQueue()
+{
+    QFile file(queueFile);
+    if(file.open(QIODevice::ReadOnly)) {
+        QJsonArray jobs = QJsonDocument::fromJson(file.readAll()).array();
+        for(const QJsonValue &v:jobs) {
+            TranscodeJob job = fromJson(v.toObject());
+            if(!QFile::exists(job.source)) continue;
+            job.id = nextId++;
+            queue.append(job);
+        }
+    }
+}
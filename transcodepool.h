@@ -0,0 +1,69 @@
+#ifndef TRANSCODEPOOL_H
+#define TRANSCODEPOOL_H
+
+#include <QObject>
+#include <QProcess>
+#include <QStringList>
+#include <QJsonObject>
+#include <QList>
+#include <QHash>
+
+// задание на перекодирование (ffmpeg)
+struct TranscodeJob {
+    quint64 id = 0;
+    QString source;
+    QString target;
+    QStringList inputArguments; // параметры источника (до "-i")
+    QStringList arguments;      // параметры результата
+    bool removeSource = true;   // удалить исходный файл после успешной конвертации
+    int attempts = 0;
+    QString tag;                // кто поставил задание
+    QJsonObject meta;           // данные владельца задания
+};
+
+// пул конвертации с ограниченным числом одновременных процессов
+// очередь сохраняется на диск и восстанавливается при следующем запуске
+class TranscodePool : public QObject
+{
+    Q_OBJECT
+
+    struct Running {
+        TranscodeJob job;
+        QProcess *process = nullptr;
+    };
+
+    QString program;
+    QString queueFile;
+    QList<TranscodeJob> queue;
+    QHash<QProcess*,Running> running;
+    quint64 nextId = 1;
+    int maxRunning;
+    quint64 finishedCnt = 0;
+    quint64 failedCnt = 0;
+
+    static const int jobTimeoutMs = 120000;
+    static const int maxAttempts = 3;
+
+    void schedule();
+    void startJob(const TranscodeJob &job);
+    void processFinished(QProcess *process, bool ok);
+    void saveQueue();
+    void loadQueue();
+    static QJsonObject toJson(const TranscodeJob &job);
+    static TranscodeJob fromJson(const QJsonObject &ob);
+
+public:
+    explicit TranscodePool(QObject *parent = nullptr);
+    ~TranscodePool();
+    quint64 enqueue(TranscodeJob job);
+    quint64 exportRecord(const QString &source, const QString &format);
+    int pendingCount() const {return queue.size();}
+    int runningCount() const {return running.size();}
+    quint64 getFinishedCount() const {return finishedCnt;}
+    quint64 getFailedCount() const {return failedCnt;}
+
+signals:
+    void jobFinished(const TranscodeJob &job, bool ok);
+};
+
+#endif // TRANSCODEPOOL_H
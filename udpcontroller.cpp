@@ -1,8 +1,8 @@
 #include "udpcontroller.h"
 
-UDPController::UDPController(const QString &ip, QObject *parent) : QObject(parent)
+UDPController::UDPController(const QString &ip, FlightRecorder *blackbox, QObject *parent) : QObject(parent)
 {
-    worker = new UDPWorker(ip);
+    worker = new UDPWorker(ip, blackbox);
     worker->moveToThread(&udpThread);
     connect(&udpThread, &QThread::finished, worker, &QObject::deleteLater);
     connect(this, &UDPController::init, worker, &UDPWorker::scan);
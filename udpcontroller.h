@@ -12,7 +12,7 @@ class UDPController : public QObject
     QThread udpThread;
     UDPWorker *worker;
 public:
-    explicit UDPController(const QString &ip, QObject *parent = nullptr);
+    explicit UDPController(const QString &ip, FlightRecorder *blackbox = nullptr, QObject *parent = nullptr);
     ~UDPController();
     void start();
     void stop();
@@ -23,6 +23,8 @@ public:
     void setIP(const QString &ip) {worker->setIP(ip);}
     void setVolume(int group,int point, int value, bool allPoints = false);
     void setInpConf(int group,int point, int filter, int enValue);
+    // источник звука записей: кадры идут в запись из потока обмена, минуя окно
+    UDPWorker *audioSource() const {return worker;}
 
 signals:
     void init();
@@ -32,7 +34,7 @@ signals:
     void updateGroupState(const QByteArray data);
     void updateState(const QByteArray data);
     void startRecord(uint8_t gr, uint8_t point);
-    void stopRecord();
+    void stopRecord(uint8_t gr, uint8_t point);
 public slots:
 };
 
@@ -134,16 +134,39 @@ QByteArray UDPWorker::createRequestCheckAudio()
     return res;
 }
 
+qint64 UDPWorker::send(QUdpSocket &udp, const QByteArray &data)
+{
+    if(blackbox) blackbox->append(FlightRecorder::RecordType::DATAGRAM,FlightRecorder::Direction::TX,gateAddress,data);
+    return udp.write(data);
+}
+
+qint64 UDPWorker::receive(QUdpSocket &udp, char *data, qint64 maxSize)
+{
+    qint64 cnt = udp.readDatagram(data,maxSize);
+    if(cnt>0 && blackbox) blackbox->append(FlightRecorder::RecordType::DATAGRAM,FlightRecorder::Direction::RX,gateAddress,data,static_cast<int>(cnt));
+    return cnt;
+}
+
+void UDPWorker::logAudio(quint8 group, quint8 point, const QByteArray &pcm)
+{
+    if(!blackbox) return;
+    QByteArray rec;
+    rec.append(static_cast<char>(group));
+    rec.append(static_cast<char>(point));
+    rec.append(pcm);
+    blackbox->append(FlightRecorder::RecordType::AUDIO,FlightRecorder::Direction::LOCAL,gateAddress,rec);
+}
+
 void UDPWorker::checkLink(QUdpSocket &udp)
 {
     static quint16 err_cnt=0;
 
-    udp.write(createRequestCheckLink());
+    send(udp,createRequestCheckLink());
     if(udp.waitForReadyRead(wait_time_ms)) {
         static char receiveBuf[1024];
         qint64 cnt = 0;
         while(udp.hasPendingDatagrams()) {
-            cnt = udp.readDatagram(receiveBuf,sizeof(receiveBuf));
+            cnt = receive(udp,receiveBuf,sizeof(receiveBuf));
             if(cnt==0) break;
         }
         if(cnt>0) {
@@ -170,11 +193,11 @@ void UDPWorker::readState(QUdpSocket &udp)
     static quint16 err_cnt=0;
     static char receiveBuf[1024];
     //static qint64 t=0;
-    udp.write(createRequestReadState());
+    send(udp,createRequestReadState());
     if(udp.waitForReadyRead(wait_time_ms)) {
         qint64 cnt = 0;
         while(udp.hasPendingDatagrams()) {
-            cnt = udp.readDatagram(receiveBuf,sizeof(receiveBuf));
+            cnt = receive(udp,receiveBuf,sizeof(receiveBuf));
             if(cnt==0) break;
         }
         if(cnt>0) {
@@ -184,12 +207,14 @@ void UDPWorker::readState(QUdpSocket &udp)
                 QByteArray state;
                 state.append(QByteArray::fromRawData(&receiveBuf[3],cnt-5));
                 emit updateState(state);
+                if(blackbox) blackbox->append(FlightRecorder::RecordType::POINT_STATE,FlightRecorder::Direction::LOCAL,gateAddress,state);
             }
             else if((quint8)receiveBuf[2]==0x03  && cnt==165) {
 
                 QByteArray state;
                 state.append(QByteArray::fromRawData(&receiveBuf[3],cnt-5));
                 emit updateGroupState(state);
+                if(blackbox) blackbox->append(FlightRecorder::RecordType::GROUP_STATE,FlightRecorder::Direction::LOCAL,gateAddress,state);
                 //qDebug() << QDateTime::currentMSecsSinceEpoch()-t;
                 //t= QDateTime::currentMSecsSinceEpoch();
             }
@@ -217,24 +242,23 @@ void UDPWorker::readState(QUdpSocket &udp)
 void UDPWorker::checkAudioCmd(QUdpSocket &udp)
 {
 
-    udp.write(createRequestCheckAudio());
+    send(udp,createRequestCheckAudio());
     if(udp.waitForReadyRead(wait_time_ms)) {
         static char receiveBuf[1024];
         while(udp.hasPendingDatagrams()) {
-            qint64 cnt = udp.readDatagram(receiveBuf,sizeof(receiveBuf));
+            qint64 cnt = receive(udp,receiveBuf,sizeof(receiveBuf));
             if(cnt==0) break;
         }
     }
 }
 
-UDPWorker::UDPWorker(const QString &ip, QObject *parent) : ip(ip), QObject(parent)
+UDPWorker::UDPWorker(const QString &ip, FlightRecorder *blackbox, QObject *parent) : ip(ip), blackbox(blackbox), QObject(parent)
 {
   //int tmp = 0;
   int error = 0;
   enc = opus_encoder_create(8000, 1, OPUS_APPLICATION_VOIP, &error);
   opus_encoder_ctl(enc, OPUS_SET_COMPLEXITY(1));
   opus_encoder_ctl(enc, OPUS_SET_BITRATE(8000));
-  dec = opus_decoder_create(8000, 1, &error);
 }
 
 void UDPWorker::start()
@@ -325,6 +349,7 @@ void UDPWorker::scan()
         mutex.unlock();
         if(workFlagState) {
             if(udp.state()==QUdpSocket::UnconnectedState) {
+                gateAddress = QHostAddress(ip).toIPv4Address();
                 udp.connectToHost(QHostAddress(ip),12145);
                 //qDebug() << "TRY CONNECT" << ip;
                 //QThread::msleep(100);
@@ -345,11 +370,11 @@ void UDPWorker::scan()
             if(volumeCmdState) {
                 if(volumeAllState) {
                     for(int i=0;i<volumePoint;i++) {
-                        udp.write(createRequestSetVolume(static_cast<quint8>(volumeGroup),static_cast<quint8>(i+1),static_cast<quint8>(volumeValue)));
+                        send(udp,createRequestSetVolume(static_cast<quint8>(volumeGroup),static_cast<quint8>(i+1),static_cast<quint8>(volumeValue)));
                         if(udp.waitForReadyRead(wait_time_ms)) {
                             qint64 cnt = 0;
                             while(udp.hasPendingDatagrams()) {
-                                cnt = udp.readDatagram(receiveBuf,sizeof(receiveBuf));
+                                cnt = receive(udp,receiveBuf,sizeof(receiveBuf));
                                 if(cnt==0) break;
                             }
                         }
@@ -365,12 +390,12 @@ void UDPWorker::scan()
                 }else {
                     mutex.lock();
                     volumeCmd = false;
-                    udp.write(createRequestSetVolume(static_cast<quint8>(volumeGroup),static_cast<quint8>(volumePoint),static_cast<quint8>(volumeValue)));
+                    send(udp,createRequestSetVolume(static_cast<quint8>(volumeGroup),static_cast<quint8>(volumePoint),static_cast<quint8>(volumeValue)));
                     mutex.unlock();
                     if(udp.waitForReadyRead(wait_time_ms)) {
                         qint64 cnt = 0;
                         while(udp.hasPendingDatagrams()) {
-                            cnt = udp.readDatagram(receiveBuf,sizeof(receiveBuf));
+                            cnt = receive(udp,receiveBuf,sizeof(receiveBuf));
                             if(cnt==0) break;
                         }
                     }
@@ -380,12 +405,12 @@ void UDPWorker::scan()
             if(inpCfgCmdState) {
                 mutex.lock();
                 inpCfgCmd = false;
-                udp.write(createRequestSetInputFilter(static_cast<quint8>(inpGroup),static_cast<quint8>(inpPoint),static_cast<quint8>(inpFilter),static_cast<quint8>(inpEn)));
+                send(udp,createRequestSetInputFilter(static_cast<quint8>(inpGroup),static_cast<quint8>(inpPoint),static_cast<quint8>(inpFilter),static_cast<quint8>(inpEn)));
                 mutex.unlock();
                 if(udp.waitForReadyRead(wait_time_ms)) {
                     qint64 cnt = 0;
                     while(udp.hasPendingDatagrams()) {
-                        cnt = udp.readDatagram(receiveBuf,sizeof(receiveBuf));
+                        cnt = receive(udp,receiveBuf,sizeof(receiveBuf));
                         if(cnt==0) break;
                     }
                 }
@@ -393,12 +418,12 @@ void UDPWorker::scan()
             if(newAudioPacketFlagState) {
                 mutex.lock();
                 newAudioPacketFlag=0;
-                udp.write(createRequestWriteAudio(packet,silent));
+                send(udp,createRequestWriteAudio(packet,silent));
                 mutex.unlock();
                 if (udp.waitForReadyRead(wait_time_ms)) {
                   qint64 cnt = 0;
                   while (udp.hasPendingDatagrams()) {
-                    cnt = udp.readDatagram(receiveBuf, sizeof(receiveBuf));
+                    cnt = receive(udp,receiveBuf,sizeof(receiveBuf));
                     if (cnt==0) break;
                   }
                   if(silent && (receiveBuf[2]==0x01 || receiveBuf[2]==0x02 || (quint8)receiveBuf[2]==0x82)) {
@@ -426,11 +451,16 @@ void UDPWorker::scan()
                           {
                               //qDebug() << grId << pointId << fromGroup << fromPoint;
                           //if(fromID && (toID==0xFF || toID==fromID)) {
-                              if(startFlag==false) {
-                                  startFlag = true;
-                                  emit startRecord((quint8)receiveBuf[3],(quint8)receiveBuf[4]);
+                              quint8 recGroup = (quint8)receiveBuf[3];
+                              quint8 recPoint = (quint8)receiveBuf[4];
+                              quint16 streamId = static_cast<quint16>(recGroup<<8 | recPoint);
+                              ActiveStream &stream = activeStreams[streamId];
+                              if(!stream.dec) {
+                                  int error = 0;
+                                  stream.dec.reset(opus_decoder_create(8000, 1, &error));
+                                  emit startRecord(recGroup,recPoint);
                               }
-                              if(startFlag) startTime = QDateTime::currentMSecsSinceEpoch();
+                              stream.lastPacket = QDateTime::currentMSecsSinceEpoch();
                               int offset = 6+pckt_cnt;
                               decodeBufOffset = 0;
                               for(int i=0;i<pckt_cnt;i++) {
@@ -443,9 +473,11 @@ void UDPWorker::scan()
                                           if(call_offset>=sizeof(call_wav)) call_offset=0;
                                       }
                                       emit updateAudio(inp);
+                                      emit recordAudio(recGroup,recPoint,inp);
+                                      logAudio(recGroup,recPoint,inp);
                                   }else {
                                       //qDebug() << "NOT CALL";
-                                      int frame_size = opus_decode(dec, (unsigned char *)&receiveBuf[offset], pckt_length.at(i), (opus_int16 *)&decodeBuf[decodeBufOffset], 1024, 0);
+                                      int frame_size = opus_decode(stream.dec.get(), (unsigned char *)&receiveBuf[offset], pckt_length.at(i), (opus_int16 *)&decodeBuf[decodeBufOffset], 1024, 0);
                                       offset+=pckt_length.at(i);
                                       if(frame_size==160) {
                                         QByteArray inp;
@@ -453,6 +485,8 @@ void UDPWorker::scan()
                                         decodeBufOffset += frame_size * 2;
                                         if(decodeBufOffset>=sizeof (decodeBuf)) decodeBufOffset=0;
                                         emit updateAudio(inp);
+                                        emit recordAudio(recGroup,recPoint,inp);
+                                        logAudio(recGroup,recPoint,inp);
                                       }else {
                                           //QString arr;
                                           //for(int i=0;i<cnt;i++) arr+=QString::number((unsigned char)receiveBuf[i],16)+" ";
@@ -474,11 +508,11 @@ void UDPWorker::scan()
         }else {
             if(udp.state()!=QUdpSocket::UnconnectedState) udp.disconnectFromHost();
         }
-        if(startFlag) {
-            if(QDateTime::currentMSecsSinceEpoch()-startTime>=1000) {
-                startFlag = false;
-                emit stopRecord();
-            }
+        for(auto it=activeStreams.begin();it!=activeStreams.end();) {
+            if(QDateTime::currentMSecsSinceEpoch()-it->second.lastPacket>=1000) {
+                emit stopRecord(static_cast<quint8>(it->first>>8),static_cast<quint8>(it->first&0xFF));
+                it = activeStreams.erase(it);
+            }else ++it;
         }
         if(finishFlagstate) break;
 
@@ -8,6 +8,9 @@
 //#include "speex/speex.h"
 #include "opus.h"
 #include <QDateTime>
+#include <map>
+#include <memory>
+#include "flightrecorder.h"
 
 class UDPWorker : public QObject
 {
@@ -36,7 +39,6 @@ class UDPWorker : public QObject
     //void *state;
     //void *dec_state;
     OpusEncoder *enc;
-    OpusDecoder *dec;
 
     mutable QMutex mutex;
     static quint16 id;
@@ -50,8 +52,14 @@ class UDPWorker : public QObject
     quint8 grId = 0;
     quint8 pointId = 0;
 
-    bool startFlag = false;
-    qint64 startTime;
+    // активный речевой поток: состояние декодера opus у каждого говорящего своё,
+    // иначе чередующиеся пакеты одновременных потоков портят друг другу звук
+    struct ActiveStream {
+        qint64 lastPacket = 0;
+        std::unique_ptr<OpusDecoder,void(*)(OpusDecoder*)> dec{nullptr,opus_decoder_destroy};
+    };
+    // (группа<<8 | точка) -> поток
+    std::map<quint16,ActiveStream> activeStreams;
 
     QByteArray createRequestWriteAudio(const QByteArray &input, bool silentMode = false);
     QByteArray createRequestSetVolume(quint8 group, quint8 point, quint8 value);
@@ -67,8 +75,15 @@ class UDPWorker : public QObject
     void checkAudioCmd(QUdpSocket &udp);
     QString ip;
 
+    // весь обмен со шлюзом проходит через send/receive и попадает в бортовой журнал
+    FlightRecorder *blackbox;
+    quint32 gateAddress = 0;
+    qint64 send(QUdpSocket &udp, const QByteArray &data);
+    qint64 receive(QUdpSocket &udp, char *data, qint64 maxSize);
+    void logAudio(quint8 group, quint8 point, const QByteArray &pcm);
+
 public:
-    explicit UDPWorker(const QString &ip, QObject *parent = nullptr);
+    explicit UDPWorker(const QString &ip, FlightRecorder *blackbox = nullptr, QObject *parent = nullptr);
     void start();
     void stop();
     void finish();
@@ -88,7 +103,8 @@ signals:
   void updateGroupState(const QByteArray data);
   void fromIDSignal(unsigned char value);
   void startRecord(uint8_t gr, uint8_t point);
-  void stopRecord();
+  void recordAudio(uint8_t gr, uint8_t point, QByteArray data);
+  void stopRecord(uint8_t gr, uint8_t point);
 public slots:
     void scan();
 
@@ -0,0 +1,139 @@
+#include "waveformpyramid.h"
+#include <QDataStream>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <algorithm>
+
+static const quint32 wfmMagicV1 = 0x57464D31; // "WFM1" - без усиления
+static const quint32 wfmMagic = 0x57464D32; // "WFM2"
+
+WaveformPyramid::WaveformPyramid(int sampleRate) : sampleRate(sampleRate)
+{
+    clear();
+}
+
+void WaveformPyramid::clear()
+{
+    levels.assign(maxLevels,std::vector<Peak>());
+    partial.assign(maxLevels,Peak());
+    partialCnt.assign(maxLevels,0);
+    carry.clear();
+    samples = 0;
+}
+
+void WaveformPyramid::setGain(double gain, double sourceGain)
+{
+    this->gain = gain;
+    scale = gain/sourceGain;
+}
+
+void WaveformPyramid::push(int n, const Peak &p, int cnt)
+{
+    // cnt - сколько элементов уровня n-1 (или отсчётов для n=0) вошло в точку
+    Peak &acc = partial[static_cast<size_t>(n)];
+    int &accCnt = partialCnt[static_cast<size_t>(n)];
+    if(accCnt==0) acc = p;
+    else {
+        acc.min = std::min(acc.min,p.min);
+        acc.max = std::max(acc.max,p.max);
+    }
+    accCnt += cnt;
+    int full = n==0 ? baseBlock : factor;
+    if(accCnt>=full) {
+        levels[static_cast<size_t>(n)].push_back(acc);
+        accCnt = 0;
+        if(n+1<maxLevels) push(n+1,acc,1);
+    }
+}
+
+void WaveformPyramid::append(const QByteArray &pcm)
+{
+    QByteArray data = carry + pcm;
+    int cnt = data.size()/2;
+    carry = data.size()&1 ? data.right(1) : QByteArray();
+    const uchar *p = reinterpret_cast<const uchar*>(data.constData());
+    for(int i=0;i<cnt;i++) {
+        qint16 s = static_cast<qint16>(p[2*i] | (p[2*i+1]<<8));
+        if(scale!=1.0) s = static_cast<qint16>(qBound(-32768.0,s*scale,32767.0));
+        push(0,Peak{s,s},1);
+    }
+    samples += cnt;
+}
+
+void WaveformPyramid::finish()
+{
+    // дописываем неполные блоки снизу вверх
+    for(int n=0;n<maxLevels;n++) {
+        if(partialCnt[static_cast<size_t>(n)]==0) continue;
+        Peak p = partial[static_cast<size_t>(n)];
+        levels[static_cast<size_t>(n)].push_back(p);
+        partialCnt[static_cast<size_t>(n)] = 0;
+        if(n+1<maxLevels) push(n+1,p,1);
+    }
+    // пустые верхние уровни не нужны
+    while(levels.size()>1 && levels.back().empty()) levels.pop_back();
+}
+
+qint64 WaveformPyramid::samplesPerPeak(int n) const
+{
+    qint64 cnt = baseBlock;
+    for(int i=0;i<n;i++) cnt *= factor;
+    return cnt;
+}
+
+int WaveformPyramid::levelFor(double samplesPerPixel) const
+{
+    // самый грубый уровень, у которого на пиксель приходится хотя бы одна точка
+    int n = 0;
+    while(n+1<levelCount() && samplesPerPeak(n+1)<=samplesPerPixel) n++;
+    return n;
+}
+
+bool WaveformPyramid::save(const QString &fileName) const
+{
+    QSaveFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly)) return false;
+    QDataStream out(&file);
+    out << wfmMagic << qint32(sampleRate) << qint32(baseBlock) << qint32(factor) << qint64(samples) << gain << qint32(levels.size());
+    for(const std::vector<Peak> &l:levels) {
+        out << qint32(l.size());
+        for(const Peak &p:l) out << p.min << p.max;
+    }
+    return file.commit();
+}
+
+bool WaveformPyramid::load(const QString &fileName)
+{
+    clear();
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly)) return false;
+    QDataStream in(&file);
+    quint32 magic;
+    qint32 rate, block, fact, levelCnt;
+    qint64 cnt;
+    double fileGain = 1.0;
+    in >> magic >> rate >> block >> fact >> cnt;
+    if(magic==wfmMagic) in >> fileGain;
+    in >> levelCnt;
+    if((magic!=wfmMagic && magic!=wfmMagicV1) || block!=baseBlock || fact!=factor || levelCnt<1 || levelCnt>maxLevels) return false;
+    levels.assign(static_cast<size_t>(levelCnt),std::vector<Peak>());
+    for(std::vector<Peak> &l:levels) {
+        qint32 size;
+        in >> size;
+        if(size<0 || size>file.size()/4) {clear();return false;}
+        l.resize(static_cast<size_t>(size));
+        for(Peak &p:l) in >> p.min >> p.max;
+    }
+    if(in.status()!=QDataStream::Ok) {clear();return false;}
+    sampleRate = rate;
+    samples = cnt;
+    setGain(fileGain);
+    return true;
+}
+
+QString WaveformPyramid::sidecarName(const QString &audioFile)
+{
+    QFileInfo info(audioFile);
+    return info.absolutePath()+"/"+info.completeBaseName()+".wfm";
+}
@@ -0,0 +1,58 @@
+#ifndef WAVEFORMPYRAMID_H
+#define WAVEFORMPYRAMID_H
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QString>
+#include <vector>
+
+// многоуровневая огибающая (min/max) звука s16le
+// строится по мере записи и хранится рядом с файлом записи (*.wfm)
+class WaveformPyramid
+{
+public:
+    struct Peak {
+        qint16 min = 0;
+        qint16 max = 0;
+    };
+
+    static const int baseBlock = 64;    // отсчётов на точку нижнего уровня (8 мс при 8 кГц)
+    static const int factor = 4;        // во сколько раз укрупняется каждый следующий уровень
+    static const int maxLevels = 8;
+    static constexpr double recordGain = 2.0;  // усиление звука при кодировании записи в mp3
+
+    explicit WaveformPyramid(int sampleRate = 8000);
+    void clear();
+    // gain - усиление огибающей относительно исходной записи, хранится в файле огибающей
+    // sourceGain - усиление уже содержащееся в добавляемых отсчётах
+    void setGain(double gain, double sourceGain = 1.0);
+    double getGain() const {return gain;}
+    void append(const QByteArray &pcm);
+    void finish();
+    bool save(const QString &fileName) const;
+    bool load(const QString &fileName);
+
+    int levelCount() const {return static_cast<int>(levels.size());}
+    const std::vector<Peak>& level(int n) const {return levels[static_cast<size_t>(n)];}
+    qint64 samplesPerPeak(int n) const;
+    int levelFor(double samplesPerPixel) const;
+    qint64 getSampleCount() const {return samples;}
+    int getSampleRate() const {return sampleRate;}
+    double duration() const {return static_cast<double>(samples)/sampleRate;}
+
+    static QString sidecarName(const QString &audioFile);
+
+private:
+    std::vector<std::vector<Peak>> levels;
+    std::vector<Peak> partial;      // незаполненный блок каждого уровня
+    std::vector<int> partialCnt;
+    QByteArray carry;               // нечётный байт между вызовами append
+    int sampleRate;
+    qint64 samples = 0;
+    double gain = 1.0;
+    double scale = 1.0;             // множитель отсчётов при добавлении
+
+    void push(int n, const Peak &p, int cnt);
+};
+
+#endif // WAVEFORMPYRAMID_H
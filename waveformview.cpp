@@ -0,0 +1,205 @@
+#include "waveformview.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QUrl>
+
+WaveformView::WaveformView(QWidget *parent) : QCustomPlot(parent)
+{
+    // graph(0) - минимумы, graph(1) - максимумы, между ними заливка
+    addGraph();
+    addGraph();
+    graph(1)->setChannelFillGraph(graph(0));
+    graph(1)->setBrush(QBrush(QColor(0,0,255,80)));
+    yAxis->setRange(-32768,32767);
+    yAxis->setTickLabels(false);
+    xAxis->setRange(0,1);
+    setInteractions(QCP::iRangeDrag | QCP::iRangeZoom);
+    axisRect()->setRangeDrag(Qt::Horizontal);
+    axisRect()->setRangeZoom(Qt::Horizontal);
+
+    cursor = new QCPItemStraightLine(this);
+    cursor->setPen(QPen(Qt::red));
+    cursor->setVisible(false);
+
+    connect(xAxis, QOverload<const QCPRange&>::of(&QCPAxis::rangeChanged), this, &WaveformView::rangeChanged);
+
+    player = new QMediaPlayer(this);
+    player->setNotifyInterval(50);
+    connect(player, &QMediaPlayer::positionChanged, this, &WaveformView::positionChanged);
+}
+
+WaveformView::~WaveformView()
+{
+    if(decoder) {
+        decoder->disconnect(this);
+        decoder->kill();
+        decoder->waitForFinished(1000);
+    }
+}
+
+void WaveformView::setRecord(const QString &fileName)
+{
+    player->stop();
+    player->setMedia(QUrl::fromLocalFile(fileName));
+    cursor->setVisible(false);
+    audioFile = fileName;
+    detail.clear();
+    decodeAgain = false;
+    if(decoder) {
+        decoder->disconnect(this);
+        decoder->kill();
+        decoder->deleteLater();
+        decoder = nullptr;
+    }
+    if(pyramid.load(WaveformPyramid::sidecarName(fileName))) {
+        fullDecode = false;
+        xAxis->setRange(0,qMax(pyramid.duration(),0.1));
+    }else {
+        // старая запись без огибающей - строим её один раз и сохраняем
+        pyramid.clear();
+        // декодированный mp3 уже содержит усиление записи
+        pyramid.setGain(WaveformPyramid::recordGain,WaveformPyramid::recordGain);
+        fullDecode = true;
+        startDecode(0,-1);
+    }
+    updateGraphs();
+    replot(rpQueuedReplot);
+}
+
+void WaveformView::startDecode(double from, double duration)
+{
+    QDir dir(QCoreApplication::applicationDirPath());
+    QStringList args;
+    args << "-loglevel" << "fatal";
+    // -ss перед -i: ffmpeg переходит к нужному месту и декодирует только запрошенный участок
+    if(duration>0) args << "-ss" << QString::number(from,'f',3) << "-t" << QString::number(duration,'f',3);
+    args << "-i" << audioFile << "-f" << "s16le" << "-ac" << "1" << "-ar" << QString::number(pyramid.getSampleRate()) << "-";
+
+    decodeFrom = from;
+    decoder = new QProcess(this);
+    decoder->setProgram(dir.absolutePath()+"/utils/ffmpeg.exe");
+    decoder->setArguments(args);
+    connect(decoder, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, [this](int exitCode, QProcess::ExitStatus status){
+        decodeFinished(status==QProcess::NormalExit && exitCode==0);
+    });
+    connect(decoder, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error){
+        if(error==QProcess::FailedToStart) decodeFinished(false);
+    });
+    decoder->start(QIODevice::ReadOnly);
+}
+
+void WaveformView::decodeFinished(bool ok)
+{
+    QProcess *process = decoder;
+    decoder = nullptr;
+    QByteArray data = ok ? process->readAllStandardOutput() : QByteArray();
+    process->disconnect(this);
+    process->deleteLater();
+
+    if(fullDecode) {
+        fullDecode = false;
+        pyramid.append(data);
+        pyramid.finish();
+        if(pyramid.getSampleCount()>0) pyramid.save(WaveformPyramid::sidecarName(audioFile));
+        xAxis->setRange(0,qMax(pyramid.duration(),0.1));
+    }else {
+        const uchar *p = reinterpret_cast<const uchar*>(data.constData());
+        detail.resize(data.size()/2);
+        // отсчёты mp3 приводятся к масштабу огибающей (старые огибающие строились без усиления)
+        double scale = pyramid.getGain()/WaveformPyramid::recordGain;
+        for(int i=0;i<detail.size();i++) {
+            qint16 s = static_cast<qint16>(p[2*i] | (p[2*i+1]<<8));
+            detail[i] = scale==1.0 ? s : static_cast<qint16>(qBound(-32768.0,s*scale,32767.0));
+        }
+        detailFrom = decodeFrom;
+        if(decodeAgain) {
+            decodeAgain = false;
+            rangeChanged(xAxis->range());
+            return;
+        }
+    }
+    updateGraphs();
+    replot(rpQueuedReplot);
+}
+
+bool WaveformView::detailCovers(const QCPRange &range) const
+{
+    if(detail.isEmpty()) return false;
+    double rate = pyramid.getSampleRate();
+    double detailTo = detailFrom+(detail.size()+1)/rate;
+    return range.lower>=detailFrom && qMin(range.upper,pyramid.duration())<=detailTo;
+}
+
+void WaveformView::rangeChanged(const QCPRange &range)
+{
+    double total = pyramid.duration();
+    if(total>0 && (range.lower<0 || range.upper>total)) {
+        // повторный вызов придёт уже с допустимым диапазоном
+        QCPRange bounded = range.bounded(0,total);
+        if(bounded!=range) {
+            xAxis->setRange(bounded);
+            return;
+        }
+    }
+    if(!fullDecode && range.size()<=detailSpan && !detailCovers(range)) {
+        // декодируем с запасом по обе стороны, чтобы перетаскивание не требовало нового запуска
+        if(decoder) decodeAgain = true;
+        else startDecode(qMax(0.0,range.lower-range.size()),range.size()*3);
+    }
+    updateGraphs();
+    replot(rpQueuedReplot);
+}
+
+void WaveformView::updateGraphs()
+{
+    QCPRange range = xAxis->range();
+    double rate = pyramid.getSampleRate();
+    QVector<double> x, lo, hi;
+
+    if(range.size()<=detailSpan && detailCovers(range)) {
+        int first = qMax(0,static_cast<int>((range.lower-detailFrom)*rate));
+        int last = qMin(detail.size(),static_cast<int>((range.upper-detailFrom)*rate)+2);
+        for(int i=first;i<last;i++) {
+            x.append(detailFrom+i/rate);
+            lo.append(detail[i]);
+        }
+        graph(0)->setData(x,lo,true);
+        graph(1)->data()->clear();
+        return;
+    }
+
+    // уровень огибающей выбирается так, чтобы на пиксель приходилось около одной точки
+    int width = qMax(1,axisRect()->width());
+    int n = pyramid.levelFor(range.size()*rate/width);
+    const std::vector<WaveformPyramid::Peak> &peaks = pyramid.level(n);
+    double step = pyramid.samplesPerPeak(n)/rate;
+    int first = qMax(0,static_cast<int>(range.lower/step));
+    int last = qMin(static_cast<int>(peaks.size()),static_cast<int>(range.upper/step)+2);
+    for(int i=first;i<last;i++) {
+        x.append(i*step);
+        lo.append(peaks[static_cast<size_t>(i)].min);
+        hi.append(peaks[static_cast<size_t>(i)].max);
+    }
+    graph(0)->setData(x,lo,true);
+    graph(1)->setData(x,hi,true);
+}
+
+void WaveformView::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    // воспроизведение с выбранного места
+    if(!audioFile.isEmpty()) {
+        double t = qMax(0.0,xAxis->pixelToCoord(event->pos().x()));
+        player->setPosition(static_cast<qint64>(t*1000));
+        player->play();
+    }
+    QCustomPlot::mouseDoubleClickEvent(event);
+}
+
+void WaveformView::positionChanged(qint64 position)
+{
+    double t = position/1000.0;
+    cursor->point1->setCoords(t,0);
+    cursor->point2->setCoords(t,1);
+    cursor->setVisible(true);
+    replot(rpQueuedReplot);
+}
@@ -0,0 +1,48 @@
+#ifndef WAVEFORMVIEW_H
+#define WAVEFORMVIEW_H
+
+#include "qcustomplot.h"
+#include "waveformpyramid.h"
+#include <QMediaPlayer>
+#include <QProcess>
+#include <QVector>
+
+// просмотр и прослушивание записи из архива
+// обзор строится по готовой огибающей, отсчёты декодируются только для видимого участка
+class WaveformView : public QCustomPlot
+{
+    Q_OBJECT
+
+    WaveformPyramid pyramid;
+    QString audioFile;
+    QMediaPlayer *player;
+    QCPItemStraightLine *cursor;
+
+    QProcess *decoder = nullptr;
+    bool fullDecode = false;        // огибающей нет, декодируется весь файл
+    bool decodeAgain = false;       // видимый участок изменился во время декодирования
+    double decodeFrom = 0;
+    QVector<qint16> detail;         // декодированные отсчёты видимого участка
+    double detailFrom = 0;
+
+    static constexpr double detailSpan = 10.0;     // с, короче - показываются отсчёты
+
+    void startDecode(double from, double duration);
+    void decodeFinished(bool ok);
+    void updateGraphs();
+    bool detailCovers(const QCPRange &range) const;
+
+public:
+    explicit WaveformView(QWidget *parent = nullptr);
+    ~WaveformView();
+    void setRecord(const QString &fileName);
+
+protected:
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+
+private slots:
+    void rangeChanged(const QCPRange &range);
+    void positionChanged(qint64 position);
+};
+
+#endif // WAVEFORMVIEW_H